@@ -0,0 +1,381 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <math.h>
+#include <string>
+#include <vector>
+#include "equationparser.h"
+#include "equivalence.h"
+#include "expressiongraph.h"
+#include "jsonline.h"
+#include "karnaughmap.h"
+#include "truthtable.h"
+#include "util.h"
+
+// The stats counters sit on the paths being timed
+#ifdef ENABLE_STATS
+#error The benchmark has to be built without ENABLE_STATS
+#endif
+
+#ifdef _WIN32
+#define NULL_DEVICE "NUL"
+#else
+#define NULL_DEVICE "/dev/null"
+#endif
+
+// Each sample repeats the body until it has run at least this long
+#define BENCHMARK_SAMPLE_NS 20000000.0
+// Bodies slower than this only get a few samples
+#define BENCHMARK_SLOW_NS 1000000000.0
+
+struct BenchmarkOptions
+{
+	int samples;
+	int maxVariables;
+	int maxTokens;
+	std::string filter;
+	std::string jsonPath;
+};
+
+struct BenchmarkResult
+{
+	std::string name;
+	int size;
+	std::string sizeUnit;
+	std::string unit;
+	uint64_t unitsPerRun;
+	int samples;
+	double medianNs;
+	double minNs;
+	double meanNs;
+	double stddevNs;
+};
+
+// Keeps results alive so the optimizer can't drop the work
+static volatile uint64_t g_sink;
+
+static double GetTimeNs() {
+	return (double)std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now().time_since_epoch() ).count();
+}
+
+static uint64_t NextRandom( uint64_t *pState )
+{
+	*pState ^= *pState << 13;
+	*pState ^= *pState >> 7;
+	*pState ^= *pState << 17;
+	return *pState;
+}
+
+// A sum of products over exactly variableCount letters with roughly
+// tokenCount tokens, written the way people type them (implicit ANDs,
+// primes, the odd parenthesised XOR term)
+static std::string GenerateEquation( int variableCount, int tokenCount, uint64_t seed )
+{
+	uint64_t state = seed * 0x9E3779B97F4A7C15ULL + 1;
+	std::string equation;
+	int tokens = 0, nextVariable = 0;
+
+	while( tokens < tokenCount || nextVariable < variableCount )
+	{
+		int literals = 1 + (int)(NextRandom( &state ) % std::min( variableCount, 4 ));
+		bool grouped = (NextRandom( &state ) % 8) == 0;
+
+		if( equation != "" ) {
+			equation += (grouped ? '^' : '+');
+			tokens++;
+		}
+		if( grouped )
+			equation += '(';
+		for( int i = 0; i < literals; i++ )
+		{
+			// Make sure every variable shows up at least once
+			int variable = (nextVariable < variableCount ? nextVariable++ : (int)(NextRandom( &state ) % variableCount));
+			equation += (char)('A' + variable);
+			if( NextRandom( &state ) % 2 )
+				equation += '\'';
+			tokens += (i == 0 ? 1 : 2);
+		}
+		if( grouped ) {
+			equation += ')';
+			tokens += 2;
+		}
+	}
+
+	return equation;
+}
+
+static void RunBenchmark( const BenchmarkOptions& options, const std::string& name, int size, const char *pSizeUnit, const char *pUnit,
+	uint64_t unitsPerRun, std::function<void()> body, std::vector<BenchmarkResult> *pResults )
+{
+	BenchmarkResult result;
+	std::vector<double> samples;
+	double start, once;
+	uint64_t repeats;
+
+	if( options.filter != "" && name.find( options.filter ) == std::string::npos )
+		return;
+
+	// Warm up and calibrate on the same run
+	start = GetTimeNs();
+	body();
+	once = std::max( GetTimeNs() - start, 1.0 );
+	repeats = (uint64_t)std::max( 1.0, BENCHMARK_SAMPLE_NS / once );
+
+	result.samples = (once > BENCHMARK_SLOW_NS ? std::min( options.samples, 3 ) : options.samples);
+	for( int i = 0; i < result.samples; i++ ) {
+		start = GetTimeNs();
+		for( uint64_t j = 0; j < repeats; j++ )
+			body();
+		samples.push_back( (GetTimeNs() - start) / repeats );
+	}
+	std::sort( samples.begin(), samples.end() );
+
+	result.name = name;
+	result.size = size;
+	result.sizeUnit = pSizeUnit;
+	result.unit = pUnit;
+	result.unitsPerRun = unitsPerRun;
+	result.medianNs = samples[samples.size() / 2];
+	result.minNs = samples[0];
+	result.meanNs = 0;
+	for( auto it = samples.begin(); it != samples.end(); it++ )
+		result.meanNs += (*it);
+	result.meanNs /= samples.size();
+	result.stddevNs = 0;
+	for( auto it = samples.begin(); it != samples.end(); it++ )
+		result.stddevNs += ((*it) - result.meanNs) * ((*it) - result.meanNs);
+	result.stddevNs = sqrt( result.stddevNs / samples.size() );
+
+	double perUnit = result.medianNs / unitsPerRun;
+	printf( " %-12s %8d %-9s %14.2f ns/%-6s %14.0f %s/s  (+/- %.1f%%, %d samples)\n", name.c_str(), size, pSizeUnit, perUnit, pUnit,
+		1e9 / perUnit, pUnit, 100.0 * result.stddevNs / result.meanNs, result.samples );
+	fflush( stdout );
+	pResults->push_back( result );
+}
+
+static void WriteJson( const std::string& path, const std::vector<BenchmarkResult>& results )
+{
+	FILE *pFile = fopen( path.c_str(), "w" );
+	if( !pFile ) {
+		printf( "ERROR: Could not open %s for writing\n", path.c_str() );
+		return;
+	}
+
+	fprintf( pFile, "[\n" );
+	for( unsigned int i = 0; i < results.size(); i++ )
+	{
+		const BenchmarkResult& result = results[i];
+		double perUnit = result.medianNs / result.unitsPerRun;
+		CJsonWriter writer;
+		writer.addString( "name", result.name );
+		writer.addNumber( "size", (int64_t)result.size );
+		writer.addString( "size_unit", result.sizeUnit );
+		writer.addString( "unit", result.unit );
+		writer.addNumber( "units_per_run", (int64_t)result.unitsPerRun );
+		writer.addNumber( "samples", (int64_t)result.samples );
+		writer.addNumber( "median_ns", result.medianNs );
+		writer.addNumber( "min_ns", result.minNs );
+		writer.addNumber( "mean_ns", result.meanNs );
+		writer.addNumber( "stddev_ns", result.stddevNs );
+		writer.addNumber( "ns_per_unit", perUnit );
+		writer.addNumber( "units_per_second", 1e9 / perUnit );
+		fprintf( pFile, "  %s%s\n", writer.finish().c_str(), (i + 1 < results.size() ? "," : "") );
+	}
+	fprintf( pFile, "]\n" );
+	fclose( pFile );
+}
+
+static void BenchmarkParse( const BenchmarkOptions& options, std::vector<BenchmarkResult> *pResults )
+{
+	for( int tokens = 10; tokens <= options.maxTokens; tokens *= 10 )
+	{
+		std::string equation = GenerateEquation( 8, tokens, tokens );
+		RunBenchmark( options, "parse", tokens, "tokens", "token", tokens, [&equation]() {
+			CEquationParser parser;
+			int parseError;
+			parser.parse( equation, &parseError );
+			g_sink += parser.getTokens().size();
+		}, pResults );
+	}
+}
+
+static void BenchmarkEvaluate( const BenchmarkOptions& options, std::vector<BenchmarkResult> *pResults )
+{
+	for( int variables = 4; variables <= std::min( options.maxVariables, 16 ); variables += 4 )
+	{
+		CEquationParser parser;
+		std::vector<std::string> inputs;
+		int parseError;
+
+		parser.parse( GenerateEquation( variables, 100, variables ), &parseError );
+		for( int i = 0; i < parser.getMaxInputs(); i++ )
+			inputs.push_back( ConvertIntToBinary( i, variables ) );
+
+		RunBenchmark( options, "evaluate", variables, "variables", "row", inputs.size(), [&parser, &inputs]() {
+			bool result;
+			int parseError;
+			for( auto it = inputs.begin(); it != inputs.end(); it++ ) {
+				parser.evaluate( (*it), &result, &parseError );
+				g_sink += result;
+			}
+		}, pResults );
+	}
+}
+
+static void BenchmarkTruthTable( const BenchmarkOptions& options, std::vector<BenchmarkResult> *pResults )
+{
+	for( int variables = 4; variables <= options.maxVariables; variables += (variables < 24 ? 4 : 2) )
+	{
+		CEquationParser parser;
+		CExpressionGraph graph;
+		int parseError;
+
+		parser.parse( GenerateEquation( variables, 100, variables ), &parseError );
+		graph.addEquation( parser, &parseError );
+
+		RunBenchmark( options, "truthtable", variables, "variables", "row", (uint64_t)1 << variables, [&graph]() {
+			std::vector<CTruthTable> tables;
+			graph.evaluateTables( &tables );
+			g_sink += tables[0].getWord( 0 );
+		}, pResults );
+	}
+}
+
+static void BenchmarkGrayCode( const BenchmarkOptions& options, std::vector<BenchmarkResult> *pResults )
+{
+	for( int bits = 4; bits <= std::min( options.maxVariables, 20 ); bits += 4 )
+	{
+		RunBenchmark( options, "graycode", bits, "bits", "code", (uint64_t)1 << bits, [bits]() {
+			g_sink += GenerateGrayCode( bits ).size();
+		}, pResults );
+	}
+}
+
+static void BenchmarkKarnaughMap( const BenchmarkOptions& options, std::vector<BenchmarkResult> *pResults )
+{
+	FILE *pNull = fopen( NULL_DEVICE, "w" );
+	if( !pNull )
+		return;
+
+	for( int variables = 2; variables <= std::min( options.maxVariables, 8 ); variables += 2 )
+	{
+		CEquationParser parser;
+		CExpressionGraph graph;
+		std::vector<CTruthTable> tables;
+		std::string columns, rows;
+		CKarnaughMap kmap;
+		int parseError;
+
+		parser.parse( GenerateEquation( variables, 40, variables ), &parseError );
+		graph.addEquation( parser, &parseError );
+		graph.evaluateTables( &tables );
+
+		kmap.m_uniqueVariables = parser.getUniqueVariables();
+		tables[0].getMinterms( &kmap.m_minTerms );
+		tables[0].getMaxterms( &kmap.m_maxTerms );
+		columns = std::string( kmap.m_uniqueVariables.begin(), kmap.m_uniqueVariables.begin() + variables / 2 );
+		rows = std::string( kmap.m_uniqueVariables.begin() + variables / 2, kmap.m_uniqueVariables.end() );
+		kmap.setColumnVars( columns );
+		kmap.setRowVars( rows );
+
+		RunBenchmark( options, "kmap", variables, "variables", "cell", (uint64_t)1 << variables, [&kmap, pNull]() {
+			kmap.print( pNull );
+		}, pResults );
+	}
+	fclose( pNull );
+}
+
+static void BenchmarkCompare( const BenchmarkOptions& options, std::vector<BenchmarkResult> *pResults )
+{
+	// The row by row flow of the interactive comparison mode
+	for( int variables = 4; variables <= std::min( options.maxVariables, 16 ); variables += 4 )
+	{
+		CEquationParser parser, comparisonParser;
+		std::vector<std::string> inputs;
+		std::string equation;
+		int parseError;
+
+		equation = GenerateEquation( variables, 100, variables );
+		parser.parse( equation, &parseError );
+		comparisonParser.parse( "((" + equation + ")')'", &parseError );
+		for( int i = 0; i < parser.getMaxInputs(); i++ )
+			inputs.push_back( ConvertIntToBinary( i, variables ) );
+
+		RunBenchmark( options, "compare", variables, "variables", "row", inputs.size(), [&parser, &comparisonParser, &inputs]() {
+			bool result, comparisonResult;
+			int parseError;
+			for( auto it = inputs.begin(); it != inputs.end(); it++ ) {
+				parser.evaluate( (*it), &result, &parseError );
+				comparisonParser.evaluate( (*it), &comparisonResult, &parseError );
+				g_sink += (result == comparisonResult);
+			}
+		}, pResults );
+	}
+
+	// Early exit equivalence check, worst case where the equations are equal
+	for( int variables = 8; variables <= options.maxVariables; variables += 4 )
+	{
+		CEquationParser parser, comparisonParser;
+		CExpressionGraph graph;
+		std::string equation;
+		int parseError;
+
+		// Absorption keeps the function but not the structure, so nothing
+		// short of checking every row proves them equal
+		equation = GenerateEquation( variables, 100, variables );
+		parser.parse( equation, &parseError );
+		comparisonParser.parse( "(" + equation + ")(" + equation + "+A)", &parseError );
+		graph.addEquation( parser, &parseError );
+		graph.addEquation( comparisonParser, &parseError );
+
+		RunBenchmark( options, "equivalence", variables, "variables", "row", (uint64_t)1 << variables, [&graph]() {
+			EquivalenceResult result;
+			CheckEquivalence( graph, 0, 1, &result );
+			g_sink += result.equal;
+		}, pResults );
+	}
+}
+
+static std::string GetOption( int argc, char *argv[], const char *pName, std::string fallback )
+{
+	for( int i = 1; i < argc - 1; i++ ) {
+		if( std::string( argv[i] ) == pName )
+			return argv[i + 1];
+	}
+	return fallback;
+}
+
+int main( int argc, char *argv[] )
+{
+	std::vector<BenchmarkResult> results;
+	BenchmarkOptions options;
+
+	for( int i = 1; i < argc; i++ ) {
+		if( std::string( argv[i] ) == "--help" ) {
+			printf( "Usage: BinaryAlgebraBench [--json <file>] [--samples <n>] [--max-vars <n>] [--max-tokens <n>] [--filter <name>]\n" );
+			return 0;
+		}
+	}
+	options.jsonPath = GetOption( argc, argv, "--json", "" );
+	options.filter = GetOption( argc, argv, "--filter", "" );
+	options.samples = std::max( 1, (int)strtol( GetOption( argc, argv, "--samples", "7" ).c_str(), 0, 10 ) );
+	// Variables are single letters, so 26 is as far as the grammar goes
+	options.maxVariables = std::min( 26, (int)strtol( GetOption( argc, argv, "--max-vars", "24" ).c_str(), 0, 10 ) );
+	options.maxTokens = (int)strtol( GetOption( argc, argv, "--max-tokens", "100000" ).c_str(), 0, 10 );
+
+	printf( "\n  Binary Algebra Solver benchmarks\n\n" );
+	BenchmarkParse( options, &results );
+	BenchmarkEvaluate( options, &results );
+	BenchmarkTruthTable( options, &results );
+	BenchmarkGrayCode( options, &results );
+	BenchmarkKarnaughMap( options, &results );
+	BenchmarkCompare( options, &results );
+
+	if( options.jsonPath != "" )
+		WriteJson( options.jsonPath, results );
+
+	return 0;
+}
@@ -0,0 +1,472 @@
+#include "aig.h"
+#include <string.h>
+#include <algorithm>
+#include <functional>
+#include <queue>
+#include "stats.h"
+
+CAig::CAig()
+{
+	memset( m_inputNodes, 0, sizeof( m_inputNodes ) );
+	m_rewriting = false;
+
+	// Node 0 is always constant false
+	AigNode node;
+	node.fanin0 = 0;
+	node.fanin1 = 0;
+	node.variable = 0;
+	node.level = 0;
+	m_nodes.push_back( node );
+}
+CAig::~CAig() {
+}
+
+uint32_t CAig::makeInput( char variable )
+{
+	uint32_t& inputNode = m_inputNodes[variable - 'A'];
+	if( inputNode != 0 )
+		return AigLiteral( inputNode, false );
+
+	AigNode node;
+	node.fanin0 = 0;
+	node.fanin1 = 0;
+	node.variable = variable;
+	node.level = 0;
+	m_nodes.push_back( node );
+	inputNode = (uint32_t)m_nodes.size() - 1;
+
+	m_uniqueVariables.insert( std::upper_bound( m_uniqueVariables.begin(), m_uniqueVariables.end(), variable ), variable );
+	return AigLiteral( inputNode, false );
+}
+
+uint32_t CAig::addAndNode( uint32_t a, uint32_t b )
+{
+	// Reuse the gate if it already exists
+	uint64_t key = ((uint64_t)a << 32) | b;
+	auto it = m_andLookup.find( key );
+	if( it != m_andLookup.end() )
+		return AigLiteral( (*it).second, false );
+
+	AigNode node;
+	node.fanin0 = a;
+	node.fanin1 = b;
+	node.variable = 0;
+	node.level = 1 + std::max( m_nodes[AigLiteralNode( a )].level, m_nodes[AigLiteralNode( b )].level );
+	m_nodes.push_back( node );
+	m_andLookup.insert( std::make_pair( key, (uint32_t)m_nodes.size() - 1 ) );
+
+	return AigLiteral( (uint32_t)m_nodes.size() - 1, false );
+}
+
+// Looks one level into the fanins of a and b for a simpler equivalent
+uint32_t CAig::rewriteAnd( uint32_t a, uint32_t b, bool *pDone )
+{
+	*pDone = true;
+
+	// One side an AND
+	for( int side = 0; side < 2; side++ )
+	{
+		uint32_t x = (side == 0 ? a : b), y = (side == 0 ? b : a);
+		if( !this->isAnd( AigLiteralNode( y ) ) )
+			continue;
+		const AigNode& node = m_nodes[AigLiteralNode( y )];
+		if( !AigLiteralIsComplemented( y ) )
+		{
+			// x & (x & c) = x & c
+			if( x == node.fanin0 || x == node.fanin1 )
+				return y;
+			// x & (!x & c) = 0
+			if( x == AigLiteralNot( node.fanin0 ) || x == AigLiteralNot( node.fanin1 ) )
+				return AIG_FALSE;
+		}
+		else
+		{
+			// x & !(!x & c) = x
+			if( x == AigLiteralNot( node.fanin0 ) || x == AigLiteralNot( node.fanin1 ) )
+				return x;
+			// x & !(x & c) = x & !c
+			if( x == node.fanin0 )
+				return this->makeAnd( x, AigLiteralNot( node.fanin1 ) );
+			if( x == node.fanin1 )
+				return this->makeAnd( x, AigLiteralNot( node.fanin0 ) );
+		}
+	}
+
+	// Both sides ANDs
+	if( this->isAnd( AigLiteralNode( a ) ) && this->isAnd( AigLiteralNode( b ) ) )
+	{
+		const AigNode& nodeA = m_nodes[AigLiteralNode( a )];
+		const AigNode& nodeB = m_nodes[AigLiteralNode( b )];
+		bool complementA = AigLiteralIsComplemented( a ), complementB = AigLiteralIsComplemented( b );
+		// Whether some fanin of one is the inverse of some fanin of the other
+		bool opposed = (nodeA.fanin0 == AigLiteralNot( nodeB.fanin0 ) || nodeA.fanin0 == AigLiteralNot( nodeB.fanin1 ) ||
+			nodeA.fanin1 == AigLiteralNot( nodeB.fanin0 ) || nodeA.fanin1 == AigLiteralNot( nodeB.fanin1 ));
+
+		// (x & c) & (!x & d) = 0
+		if( !complementA && !complementB && opposed )
+			return AIG_FALSE;
+		// (x & c) & !(!x & d) = x & c
+		if( !complementA && complementB && opposed )
+			return a;
+		if( complementA && !complementB && opposed )
+			return b;
+		// !(x & c) & !(x & !c) = !x
+		if( complementA && complementB )
+		{
+			if( nodeA.fanin0 == nodeB.fanin0 && nodeA.fanin1 == AigLiteralNot( nodeB.fanin1 ) )
+				return AigLiteralNot( nodeA.fanin0 );
+			if( nodeA.fanin0 == nodeB.fanin1 && nodeA.fanin1 == AigLiteralNot( nodeB.fanin0 ) )
+				return AigLiteralNot( nodeA.fanin0 );
+			if( nodeA.fanin1 == nodeB.fanin0 && nodeA.fanin0 == AigLiteralNot( nodeB.fanin1 ) )
+				return AigLiteralNot( nodeA.fanin1 );
+			if( nodeA.fanin1 == nodeB.fanin1 && nodeA.fanin0 == AigLiteralNot( nodeB.fanin0 ) )
+				return AigLiteralNot( nodeA.fanin1 );
+		}
+	}
+
+	*pDone = false;
+	return AIG_FALSE;
+}
+
+uint32_t CAig::makeAnd( uint32_t a, uint32_t b )
+{
+	// Commutative, so keep the fanins ordered for hashing
+	if( a > b )
+		std::swap( a, b );
+	if( a == AIG_FALSE )
+		return AIG_FALSE;
+	if( a == AIG_TRUE || a == b )
+		return b;
+	if( a == AigLiteralNot( b ) )
+		return AIG_FALSE;
+
+	if( m_rewriting ) {
+		bool done;
+		uint32_t result = this->rewriteAnd( a, b, &done );
+		if( done )
+			return result;
+	}
+	return this->addAndNode( a, b );
+}
+uint32_t CAig::makeOr( uint32_t a, uint32_t b ) {
+	return AigLiteralNot( this->makeAnd( AigLiteralNot( a ), AigLiteralNot( b ) ) );
+}
+uint32_t CAig::makeXor( uint32_t a, uint32_t b ) {
+	return this->makeOr( this->makeAnd( a, AigLiteralNot( b ) ), this->makeAnd( AigLiteralNot( a ), b ) );
+}
+
+int CAig::addOutput( uint32_t literal, std::string name )
+{
+	m_outputs.push_back( literal );
+	m_outputNames.push_back( name );
+	return (int)m_outputs.size() - 1;
+}
+
+int CAig::addGraph( const CExpressionGraph& graph )
+{
+	std::vector<uint32_t> literals( graph.getNodeCount() );
+	int firstOutput = (int)m_outputs.size();
+
+	// Every input gets a node even if the graph folded it away
+	const std::vector<char>& variables = graph.getUniqueVariables();
+	for( auto it = variables.begin(); it != variables.end(); it++ )
+		this->makeInput( (*it) );
+
+	for( int i = 0; i < graph.getNodeCount(); i++ )
+	{
+		const ExpressionNode& node = graph.getNode( i );
+		switch( node.nodeType )
+		{
+		case NODE_TYPE_CONST0:
+			literals[i] = AIG_FALSE;
+			break;
+		case NODE_TYPE_CONST1:
+			literals[i] = AIG_TRUE;
+			break;
+		case NODE_TYPE_VARIABLE:
+			literals[i] = this->makeInput( node.variable );
+			break;
+		case NODE_TYPE_NOT:
+			literals[i] = AigLiteralNot( literals[node.left] );
+			break;
+		case NODE_TYPE_AND:
+			literals[i] = this->makeAnd( literals[node.left], literals[node.right] );
+			break;
+		case NODE_TYPE_OR:
+			literals[i] = this->makeOr( literals[node.left], literals[node.right] );
+			break;
+		case NODE_TYPE_XOR:
+			literals[i] = this->makeXor( literals[node.left], literals[node.right] );
+			break;
+		}
+	}
+	for( int i = 0; i < graph.getOutputCount(); i++ )
+		this->addOutput( literals[graph.getOutput( i )], graph.getOutputEquation( i ) );
+
+	return firstOutput;
+}
+
+void CAig::markReachable( std::vector<bool> *pReachable ) const
+{
+	pReachable->assign( m_nodes.size(), false );
+	for( auto it = m_outputs.begin(); it != m_outputs.end(); it++ )
+		(*pReachable)[AigLiteralNode( (*it) )] = true;
+	// Fanins always come first, so one backwards pass finds everything
+	for( size_t i = m_nodes.size() - 1; i > 0; i-- ) {
+		if( !(*pReachable)[i] || !this->isAnd( (uint32_t)i ) )
+			continue;
+		(*pReachable)[AigLiteralNode( m_nodes[i].fanin0 )] = true;
+		(*pReachable)[AigLiteralNode( m_nodes[i].fanin1 )] = true;
+	}
+}
+
+void CAig::copyInputs( const CAig& source )
+{
+	for( auto it = source.m_uniqueVariables.begin(); it != source.m_uniqueVariables.end(); it++ )
+		this->makeInput( (*it) );
+}
+
+int CAig::addAig( const CAig& source )
+{
+	std::vector<bool> reachable;
+	std::vector<uint32_t> literals( source.m_nodes.size(), AIG_FALSE );
+	int firstOutput = (int)m_outputs.size();
+
+	this->copyInputs( source );
+	source.markReachable( &reachable );
+	for( uint32_t i = 1; i < source.m_nodes.size(); i++ )
+	{
+		const AigNode& node = source.m_nodes[i];
+		if( !reachable[i] )
+			continue;
+		if( !source.isAnd( i ) )
+			literals[i] = this->makeInput( node.variable );
+		else
+			literals[i] = this->makeAnd( literals[AigLiteralNode( node.fanin0 )] ^ (node.fanin0 & 1),
+				literals[AigLiteralNode( node.fanin1 )] ^ (node.fanin1 & 1) );
+	}
+	for( unsigned int i = 0; i < source.m_outputs.size(); i++ ) {
+		uint32_t output = source.m_outputs[i];
+		this->addOutput( literals[AigLiteralNode( output )] ^ (output & 1), source.m_outputNames[i] );
+	}
+
+	return firstOutput;
+}
+
+void CAig::rewrite()
+{
+	CAig result;
+	result.m_rewriting = true;
+	result.addAig( *this );
+	result.m_rewriting = m_rewriting;
+	(*this) = std::move( result );
+}
+
+void CAig::balance()
+{
+	std::vector<bool> reachable;
+	std::vector<uint32_t> references( m_nodes.size(), 0 );
+	std::vector<bool> roots( m_nodes.size(), false );
+
+	// A gate can be folded into the one above it when that is its only,
+	// uncomplemented, use. Everything else roots its own supergate.
+	this->markReachable( &reachable );
+	for( uint32_t i = 1; i < m_nodes.size(); i++ )
+	{
+		if( !reachable[i] || !this->isAnd( i ) )
+			continue;
+		uint32_t fanins[2] = { m_nodes[i].fanin0, m_nodes[i].fanin1 };
+		for( int j = 0; j < 2; j++ ) {
+			references[AigLiteralNode( fanins[j] )]++;
+			if( AigLiteralIsComplemented( fanins[j] ) )
+				roots[AigLiteralNode( fanins[j] )] = true;
+		}
+	}
+	for( auto it = m_outputs.begin(); it != m_outputs.end(); it++ )
+		roots[AigLiteralNode( (*it) )] = true;
+
+	CAig result;
+	std::vector<uint32_t> literals( m_nodes.size(), AIG_FALSE );
+	std::vector<uint32_t> stack, leaves;
+	typedef std::pair<uint32_t, uint32_t> LevelLiteral;
+
+	result.m_rewriting = m_rewriting;
+	result.copyInputs( *this );
+	for( uint32_t i = 1; i < m_nodes.size(); i++ )
+	{
+		if( !reachable[i] )
+			continue;
+		if( !this->isAnd( i ) ) {
+			literals[i] = result.makeInput( m_nodes[i].variable );
+			continue;
+		}
+		if( !roots[i] && references[i] == 1 )
+			continue;
+
+		// Gather the inputs of the whole supergate
+		leaves.clear();
+		stack.clear();
+		stack.push_back( m_nodes[i].fanin0 );
+		stack.push_back( m_nodes[i].fanin1 );
+		while( !stack.empty() )
+		{
+			uint32_t literal = stack.back();
+			uint32_t node = AigLiteralNode( literal );
+			stack.pop_back();
+			if( !AigLiteralIsComplemented( literal ) && this->isAnd( node ) && !roots[node] && references[node] == 1 ) {
+				stack.push_back( m_nodes[node].fanin0 );
+				stack.push_back( m_nodes[node].fanin1 );
+			}
+			else
+				leaves.push_back( literals[node] ^ (literal & 1) );
+		}
+
+		// Pair off the two shallowest until one is left
+		std::priority_queue<LevelLiteral, std::vector<LevelLiteral>, std::greater<LevelLiteral>> queue;
+		for( auto it = leaves.begin(); it != leaves.end(); it++ )
+			queue.push( LevelLiteral( result.m_nodes[AigLiteralNode( (*it) )].level, (*it) ) );
+		while( queue.size() > 1 ) {
+			uint32_t a = queue.top().second;
+			queue.pop();
+			uint32_t b = queue.top().second;
+			queue.pop();
+			uint32_t combined = result.makeAnd( a, b );
+			queue.push( LevelLiteral( result.m_nodes[AigLiteralNode( combined )].level, combined ) );
+		}
+		literals[i] = queue.top().second;
+	}
+	for( unsigned int i = 0; i < m_outputs.size(); i++ )
+		result.addOutput( literals[AigLiteralNode( m_outputs[i] )] ^ (m_outputs[i] & 1), m_outputNames[i] );
+
+	(*this) = std::move( result );
+}
+
+void CAig::optimize()
+{
+	for( int pass = 0; pass < AIG_MAX_OPTIMIZE_PASSES; pass++ )
+	{
+		CAig previous = (*this);
+		uint32_t andCount = this->getAndCount(), depth = this->getDepth(), levels = this->getLevelSum();
+
+		this->rewrite();
+		this->balance();
+
+		// Fewer gates first, then shallower, counting every output so one
+		// deep output doesn't hide the others getting better
+		uint32_t newAndCount = this->getAndCount(), newDepth = this->getDepth(), newLevels = this->getLevelSum();
+		if( newAndCount <= andCount && newDepth <= depth && newLevels <= levels &&
+			(newAndCount < andCount || newDepth < depth || newLevels < levels) )
+			continue;
+		if( newAndCount > andCount || newDepth > depth || newLevels > levels )
+			(*this) = std::move( previous );
+		break;
+	}
+}
+
+void CAig::simulateWord( const uint64_t *pSlots, uint64_t *pValues ) const
+{
+	STATS_INCREMENT( STAT_WORDS_EVALUATED );
+	STATS_ADD( STAT_NODES_VISITED, m_nodes.size() );
+
+	pValues[0] = 0;
+	for( size_t i = 1; i < m_nodes.size(); i++ )
+	{
+		const AigNode& node = m_nodes[i];
+		if( node.variable != 0 ) {
+			pValues[i] = pSlots[node.variable - 'A'];
+			continue;
+		}
+		uint64_t a = pValues[AigLiteralNode( node.fanin0 )] ^ (0 - (uint64_t)(node.fanin0 & 1));
+		uint64_t b = pValues[AigLiteralNode( node.fanin1 )] ^ (0 - (uint64_t)(node.fanin1 & 1));
+		pValues[i] = a & b;
+	}
+}
+uint64_t CAig::getOutputWord( const uint64_t *pValues, int output ) const
+{
+	uint32_t literal = m_outputs[output];
+	return pValues[AigLiteralNode( literal )] ^ (0 - (uint64_t)(literal & 1));
+}
+
+void CAig::evaluateTables( std::vector<CTruthTable> *pTables ) const
+{
+	std::vector<uint64_t> values( m_nodes.size() );
+	uint64_t slots[INPUT_SLOT_COUNT] = { 0 };
+	uint64_t wordCount;
+	STATS_TIMER( STATS_PHASE_EVALUATE );
+
+	pTables->assign( m_outputs.size(), CTruthTable( m_uniqueVariables ) );
+	wordCount = CTruthTable::getWordCount( (unsigned int)m_uniqueVariables.size() );
+
+	for( uint64_t i = 0; i < wordCount; i++ )
+	{
+		CTruthTable::fillInputSlots( m_uniqueVariables, i, slots );
+		this->simulateWord( slots, &values[0] );
+		for( unsigned int j = 0; j < m_outputs.size(); j++ )
+			(*pTables)[j].setWord( i, this->getOutputWord( &values[0], j ) );
+	}
+	STATS_ADD( STAT_ROWS_EVALUATED, (uint64_t)1 << m_uniqueVariables.size() );
+}
+
+void CAig::writeAiger( FILE *pFile ) const
+{
+	std::vector<bool> reachable;
+	std::vector<uint32_t> indices( m_nodes.size(), 0 );
+	std::vector<uint32_t> gates;
+	uint32_t nextIndex = 1;
+
+	// AIGER wants the inputs first, then the gates in topological order
+	this->markReachable( &reachable );
+	for( auto it = m_uniqueVariables.begin(); it != m_uniqueVariables.end(); it++ )
+		indices[m_inputNodes[(*it) - 'A']] = nextIndex++;
+	for( uint32_t i = 1; i < m_nodes.size(); i++ ) {
+		if( reachable[i] && this->isAnd( i ) ) {
+			indices[i] = nextIndex++;
+			gates.push_back( i );
+		}
+	}
+
+	fprintf( pFile, "aag %u %u 0 %u %u\n", nextIndex - 1, (unsigned int)m_uniqueVariables.size(), (unsigned int)m_outputs.size(), (unsigned int)gates.size() );
+	for( unsigned int i = 0; i < m_uniqueVariables.size(); i++ )
+		fprintf( pFile, "%u\n", (i + 1) * 2 );
+	for( auto it = m_outputs.begin(); it != m_outputs.end(); it++ )
+		fprintf( pFile, "%u\n", indices[AigLiteralNode( (*it) )] * 2 + ((*it) & 1) );
+	for( auto it = gates.begin(); it != gates.end(); it++ )
+	{
+		const AigNode& node = m_nodes[(*it)];
+		uint32_t left = indices[AigLiteralNode( node.fanin0 )] * 2 + (node.fanin0 & 1);
+		uint32_t right = indices[AigLiteralNode( node.fanin1 )] * 2 + (node.fanin1 & 1);
+		fprintf( pFile, "%u %u %u\n", indices[(*it)] * 2, std::max( left, right ), std::min( left, right ) );
+	}
+	for( unsigned int i = 0; i < m_uniqueVariables.size(); i++ )
+		fprintf( pFile, "i%u %c\n", i, m_uniqueVariables[i] );
+	for( unsigned int i = 0; i < m_outputNames.size(); i++ )
+		fprintf( pFile, "o%u %s\n", i, m_outputNames[i].c_str() );
+	fprintf( pFile, "c\nBinary Algebra Solver\n" );
+}
+
+uint32_t CAig::getAndCount() const
+{
+	std::vector<bool> reachable;
+	uint32_t count = 0;
+
+	this->markReachable( &reachable );
+	for( uint32_t i = 1; i < m_nodes.size(); i++ ) {
+		if( reachable[i] && this->isAnd( i ) )
+			count++;
+	}
+	return count;
+}
+uint32_t CAig::getLevelSum() const
+{
+	uint32_t levels = 0;
+	for( auto it = m_outputs.begin(); it != m_outputs.end(); it++ )
+		levels += m_nodes[AigLiteralNode( (*it) )].level;
+	return levels;
+}
+uint32_t CAig::getDepth() const
+{
+	uint32_t depth = 0;
+	for( auto it = m_outputs.begin(); it != m_outputs.end(); it++ )
+		depth = std::max( depth, m_nodes[AigLiteralNode( (*it) )].level );
+	return depth;
+}
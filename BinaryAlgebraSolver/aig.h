@@ -0,0 +1,94 @@
+#pragma once
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "expressiongraph.h"
+#include "truthtable.h"
+
+// Edges are literals, twice the node index with the low bit set when the
+// edge is complemented. Node 0 is constant false.
+#define AIG_FALSE 0
+#define AIG_TRUE 1
+// Rewriting and balancing rounds before optimize() gives up
+#define AIG_MAX_OPTIMIZE_PASSES 8
+
+inline uint32_t AigLiteral( uint32_t node, bool complemented ) { return (node << 1) | (complemented ? 1 : 0); }
+inline uint32_t AigLiteralNode( uint32_t literal ) { return literal >> 1; }
+inline bool AigLiteralIsComplemented( uint32_t literal ) { return (literal & 1) != 0; }
+inline uint32_t AigLiteralNot( uint32_t literal ) { return literal ^ 1; }
+
+struct AigNode
+{
+	uint32_t fanin0;
+	uint32_t fanin1;
+	// Set for inputs, which have no fanins
+	char variable;
+	uint32_t level;
+};
+
+// And-inverter graph, every gate is a two input AND and inversion lives on
+// the edges. ANDs are structurally hashed on their (ordered) fanins, so the
+// same gate is never built twice. Nodes are created after their fanins, so
+// index order is a topological order.
+class CAig
+{
+private:
+	std::vector<AigNode> m_nodes;
+	std::unordered_map<uint64_t, uint32_t> m_andLookup;
+	uint32_t m_inputNodes[INPUT_SLOT_COUNT];
+	std::vector<uint32_t> m_outputs;
+	std::vector<std::string> m_outputNames;
+	std::vector<char> m_uniqueVariables;
+	bool m_rewriting;
+
+	uint32_t rewriteAnd( uint32_t a, uint32_t b, bool *pDone );
+	uint32_t addAndNode( uint32_t a, uint32_t b );
+	void markReachable( std::vector<bool> *pReachable ) const;
+	void copyInputs( const CAig& source );
+	uint32_t getLevelSum() const;
+public:
+	CAig();
+	~CAig();
+
+	uint32_t makeInput( char variable );
+	uint32_t makeAnd( uint32_t a, uint32_t b );
+	uint32_t makeOr( uint32_t a, uint32_t b );
+	uint32_t makeXor( uint32_t a, uint32_t b );
+
+	// Lowers every output of the graph, returns the index of the first one
+	int addGraph( const CExpressionGraph& graph );
+	// Copies every output of another AIG in, returns the index of the first
+	int addAig( const CAig& source );
+	int addOutput( uint32_t literal, std::string name );
+
+	// Two level rewriting (contradiction, idempotence, subsumption,
+	// substitution and resolution) while rebuilding, which also drops
+	// anything no output uses
+	void rewrite();
+	// Rebuilds chains of ANDs as balanced trees, lowest levels first
+	void balance();
+	// Both of the above until neither helps
+	void optimize();
+
+	void simulateWord( const uint64_t *pSlots, uint64_t *pValues ) const;
+	uint64_t getOutputWord( const uint64_t *pValues, int output ) const;
+	void evaluateTables( std::vector<CTruthTable> *pTables ) const;
+
+	// ASCII AIGER (aag), inputs in variable order
+	void writeAiger( FILE *pFile ) const;
+
+	// AND gates reachable from the outputs
+	uint32_t getAndCount() const;
+	uint32_t getDepth() const;
+
+	inline const AigNode& getNode( uint32_t node ) const { return m_nodes[node]; }
+	inline bool isAnd( uint32_t node ) const { return node != 0 && m_nodes[node].variable == 0; }
+	inline uint32_t getNodeCount() const { return (uint32_t)m_nodes.size(); }
+	inline uint32_t getOutput( int output ) const { return m_outputs[output]; }
+	inline int getOutputCount() const { return (int)m_outputs.size(); }
+	inline const std::string& getOutputName( int output ) const { return m_outputNames[output]; }
+	inline const std::vector<char>& getUniqueVariables() const { return m_uniqueVariables; }
+	inline int getUniqueVariableCount() const { return (int)m_uniqueVariables.size(); }
+};
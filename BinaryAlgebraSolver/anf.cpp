@@ -0,0 +1,76 @@
+#include "anf.h"
+#include <algorithm>
+#include "util.h"
+
+void ComputeAnf( const CTruthTable& table, CTruthTable *pAnf )
+{
+	(*pAnf) = table;
+	pAnf->mobiusTransform();
+}
+
+void GetAnfMonomials( const CTruthTable& anf, std::vector<uint64_t> *pMonomials )
+{
+	const std::vector<uint64_t>& words = anf.getWords();
+
+	pMonomials->clear();
+	for( uint64_t i = 0; i < words.size(); i++ ) {
+		for( uint64_t word = words[i]; word != 0; word &= word - 1 )
+			pMonomials->push_back( (i << 6) + CountTrailingZeros( word ) );
+	}
+
+	// The first variable is the highest bit, so within a degree the larger
+	// monomial comes first
+	std::sort( pMonomials->begin(), pMonomials->end(), []( uint64_t a, uint64_t b )->bool {
+		int degreeA = CountSetBits( a ), degreeB = CountSetBits( b );
+		if( degreeA != degreeB )
+			return degreeA < degreeB;
+		return a > b;
+	} );
+}
+
+unsigned int GetAnfDegree( const CTruthTable& anf )
+{
+	const std::vector<uint64_t>& words = anf.getWords();
+	unsigned int degree = 0;
+
+	for( uint64_t i = 0; i < words.size(); i++ ) {
+		for( uint64_t word = words[i]; word != 0; word &= word - 1 ) {
+			unsigned int monomialDegree = CountSetBits( (i << 6) + CountTrailingZeros( word ) );
+			if( monomialDegree > degree )
+				degree = monomialDegree;
+		}
+	}
+	return degree;
+}
+
+std::string FormatAnf( const CTruthTable& anf )
+{
+	const std::vector<char>& variables = anf.getUniqueVariables();
+	unsigned int variableCount = (unsigned int)variables.size();
+	std::vector<uint64_t> monomials;
+	std::string result;
+
+	GetAnfMonomials( anf, &monomials );
+	if( monomials.empty() )
+		return "0";
+
+	for( auto it = monomials.begin(); it != monomials.end(); it++ )
+	{
+		if( it != monomials.begin() )
+			result += '^';
+		if( (*it) == 0 ) {
+			result += '1';
+			continue;
+		}
+		bool first = true;
+		for( unsigned int i = 0; i < variableCount; i++ ) {
+			if( !(((*it) >> (variableCount - 1 - i)) & 1) )
+				continue;
+			if( !first )
+				result += '*';
+			result += variables[i];
+			first = false;
+		}
+	}
+	return result;
+}
@@ -0,0 +1,18 @@
+#pragma once
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "truthtable.h"
+
+// Past this many terms only the term count and degree are reported
+#define ANF_MAX_FORMAT_TERMS 4096
+
+// Algebraic normal form (XOR of ANDs) of a truth table, as coefficients in
+// the layout CTruthTable::mobiusTransform() produces
+void ComputeAnf( const CTruthTable& table, CTruthTable *pAnf );
+// Monomials with a coefficient of one, lowest degree first and then in
+// variable order, so A*B comes before A*C
+void GetAnfMonomials( const CTruthTable& anf, std::vector<uint64_t> *pMonomials );
+unsigned int GetAnfDegree( const CTruthTable& anf );
+// Written in the solver's own grammar, e.g. 1^A*B^C, so it parses again
+std::string FormatAnf( const CTruthTable& anf );
@@ -0,0 +1,289 @@
+#include "bdd.h"
+#include <algorithm>
+
+enum
+{
+	BDD_OP_AND,
+	BDD_OP_OR,
+	BDD_OP_XOR
+};
+
+CBdd::CBdd( const std::vector<char>& variables )
+{
+	BddNode terminal;
+
+	m_variables = variables;
+	m_pProgress = 0;
+	m_overflow = false;
+	for( int i = 0; i < INPUT_SLOT_COUNT; i++ )
+		m_levels[i] = -1;
+	for( unsigned int i = 0; i < variables.size(); i++ )
+		m_levels[variables[i] - 'A'] = (int)i;
+
+	terminal.level = (uint32_t)variables.size();
+	terminal.low = 0;
+	terminal.high = 0;
+	m_nodes.push_back( terminal );
+	m_nodes.push_back( terminal );
+}
+CBdd::~CBdd() {
+}
+
+void CBdd::setProgress( CProgress *pProgress ) {
+	m_pProgress = pProgress;
+}
+
+uint32_t CBdd::makeNode( uint32_t level, uint32_t low, uint32_t high )
+{
+	if( low == high )
+		return low;
+
+	// Node ids stay under 2^29 thanks to the node limit, so they pack
+	uint64_t key = ((uint64_t)level << 58) | ((uint64_t)low << 29) | high;
+	auto it = m_uniqueTable.find( key );
+	if( it != m_uniqueTable.end() )
+		return (*it).second;
+	if( m_nodes.size() >= BDD_MAX_NODES ) {
+		m_overflow = true;
+		return BDD_FALSE;
+	}
+	if( m_pProgress && m_nodes.size() % BDD_PROGRESS_NODES == 0 && !m_pProgress->addRows( 0 ) ) {
+		m_overflow = true;
+		return BDD_FALSE;
+	}
+
+	BddNode node;
+	node.level = level;
+	node.low = low;
+	node.high = high;
+	m_nodes.push_back( node );
+	m_uniqueTable.insert( std::make_pair( key, (uint32_t)m_nodes.size() - 1 ) );
+	return (uint32_t)m_nodes.size() - 1;
+}
+
+uint32_t CBdd::apply( int op, uint32_t a, uint32_t b )
+{
+	if( m_overflow )
+		return BDD_FALSE;
+
+	switch( op )
+	{
+	case BDD_OP_AND:
+		if( a == BDD_FALSE || b == BDD_FALSE )
+			return BDD_FALSE;
+		if( a == BDD_TRUE || a == b )
+			return b;
+		if( b == BDD_TRUE )
+			return a;
+		break;
+	case BDD_OP_OR:
+		if( a == BDD_TRUE || b == BDD_TRUE )
+			return BDD_TRUE;
+		if( a == BDD_FALSE || a == b )
+			return b;
+		if( b == BDD_FALSE )
+			return a;
+		break;
+	case BDD_OP_XOR:
+		if( a == b )
+			return BDD_FALSE;
+		if( a == BDD_FALSE )
+			return b;
+		if( b == BDD_FALSE )
+			return a;
+		break;
+	}
+
+	// All three are commutative
+	if( a > b )
+		std::swap( a, b );
+	uint64_t key = ((uint64_t)op << 62) | ((uint64_t)a << 29) | b;
+	auto it = m_computed.find( key );
+	if( it != m_computed.end() )
+		return (*it).second;
+
+	// Shannon expansion on whichever operand has the top variable
+	uint32_t level = std::min( m_nodes[a].level, m_nodes[b].level );
+	uint32_t aLow = a, aHigh = a, bLow = b, bHigh = b;
+	if( m_nodes[a].level == level ) {
+		aLow = m_nodes[a].low;
+		aHigh = m_nodes[a].high;
+	}
+	if( m_nodes[b].level == level ) {
+		bLow = m_nodes[b].low;
+		bHigh = m_nodes[b].high;
+	}
+	uint32_t low = this->apply( op, aLow, bLow );
+	uint32_t high = this->apply( op, aHigh, bHigh );
+	uint32_t result = this->makeNode( level, low, high );
+
+	if( !m_overflow )
+		m_computed.insert( std::make_pair( key, result ) );
+	return result;
+}
+
+uint32_t CBdd::makeVariable( char variable ) {
+	return this->makeNode( (uint32_t)m_levels[variable - 'A'], BDD_FALSE, BDD_TRUE );
+}
+uint32_t CBdd::makeNot( uint32_t a ) {
+	return this->apply( BDD_OP_XOR, a, BDD_TRUE );
+}
+uint32_t CBdd::makeAnd( uint32_t a, uint32_t b ) {
+	return this->apply( BDD_OP_AND, a, b );
+}
+uint32_t CBdd::makeOr( uint32_t a, uint32_t b ) {
+	return this->apply( BDD_OP_OR, a, b );
+}
+uint32_t CBdd::makeXor( uint32_t a, uint32_t b ) {
+	return this->apply( BDD_OP_XOR, a, b );
+}
+
+bool CBdd::addGraphOutput( const CExpressionGraph& graph, int output, uint32_t *pRoot )
+{
+	std::vector<uint32_t> nodeMap( graph.getNodeCount(), BDD_FALSE );
+	std::vector<bool> reachable( graph.getNodeCount(), false );
+	int root = graph.getOutput( output );
+
+	// Only the output's cone, marked from the top down
+	reachable[root] = true;
+	for( int i = root; i >= 0; i-- ) {
+		const ExpressionNode& node = graph.getNode( i );
+		if( !reachable[i] )
+			continue;
+		if( node.left >= 0 )
+			reachable[node.left] = true;
+		if( node.right >= 0 )
+			reachable[node.right] = true;
+	}
+
+	for( int i = 0; i <= root && !m_overflow; i++ )
+	{
+		const ExpressionNode& node = graph.getNode( i );
+		if( !reachable[i] )
+			continue;
+		switch( node.nodeType )
+		{
+		case NODE_TYPE_CONST0:
+			nodeMap[i] = BDD_FALSE;
+			break;
+		case NODE_TYPE_CONST1:
+			nodeMap[i] = BDD_TRUE;
+			break;
+		case NODE_TYPE_VARIABLE:
+			if( m_levels[node.variable - 'A'] == -1 )
+				return false;
+			nodeMap[i] = this->makeVariable( node.variable );
+			break;
+		case NODE_TYPE_NOT:
+			nodeMap[i] = this->makeNot( nodeMap[node.left] );
+			break;
+		case NODE_TYPE_AND:
+			nodeMap[i] = this->makeAnd( nodeMap[node.left], nodeMap[node.right] );
+			break;
+		case NODE_TYPE_OR:
+			nodeMap[i] = this->makeOr( nodeMap[node.left], nodeMap[node.right] );
+			break;
+		case NODE_TYPE_XOR:
+			nodeMap[i] = this->makeXor( nodeMap[node.left], nodeMap[node.right] );
+			break;
+		}
+	}
+
+	*pRoot = nodeMap[root];
+	return !m_overflow;
+}
+
+uint64_t CBdd::countModels( uint32_t root ) const
+{
+	std::vector<uint64_t> counts( std::max( root + 1, (uint32_t)2 ), 0 );
+
+	// Children are always older than their parents. A node's count is over
+	// the variables from its level down, so an edge that skips levels
+	// leaves those variables free.
+	counts[BDD_TRUE] = 1;
+	for( uint32_t i = 2; i <= root; i++ ) {
+		const BddNode& node = m_nodes[i];
+		counts[i] = (counts[node.low] << (m_nodes[node.low].level - node.level - 1)) +
+			(counts[node.high] << (m_nodes[node.high].level - node.level - 1));
+	}
+	return counts[root] << m_nodes[root].level;
+}
+
+static void AddBddOrder( const CExpressionGraph& graph, int output, std::vector<char> *pOrder )
+{
+	std::vector<bool> visited( graph.getNodeCount(), false );
+	std::vector<int> stack( 1, graph.getOutput( output ) );
+
+	while( !stack.empty() )
+	{
+		int index = stack.back();
+		stack.pop_back();
+		if( visited[index] )
+			continue;
+		visited[index] = true;
+
+		const ExpressionNode& node = graph.getNode( index );
+		if( node.nodeType == NODE_TYPE_VARIABLE ) {
+			if( std::find( pOrder->begin(), pOrder->end(), node.variable ) == pOrder->end() )
+				pOrder->push_back( node.variable );
+			continue;
+		}
+		// Right first so the left operand comes off the stack first
+		if( node.right >= 0 )
+			stack.push_back( node.right );
+		if( node.left >= 0 )
+			stack.push_back( node.left );
+	}
+}
+
+// Variables the graph has but the output doesn't use still count
+static void AddRemainingVariables( const CExpressionGraph& graph, std::vector<char> *pOrder )
+{
+	const std::vector<char>& variables = graph.getUniqueVariables();
+	for( auto it = variables.begin(); it != variables.end(); it++ ) {
+		if( std::find( pOrder->begin(), pOrder->end(), (*it) ) == pOrder->end() )
+			pOrder->push_back( (*it) );
+	}
+}
+
+void GetBddOrder( const CExpressionGraph& graph, int output, std::vector<char> *pOrder )
+{
+	pOrder->clear();
+	AddBddOrder( graph, output, pOrder );
+	AddRemainingVariables( graph, pOrder );
+}
+
+bool CountModels( const CExpressionGraph& graph, int output, uint64_t *pCount, CProgress *pProgress )
+{
+	std::vector<char> order;
+	uint32_t root;
+
+	GetBddOrder( graph, output, &order );
+	CBdd bdd( order );
+	bdd.setProgress( pProgress );
+	if( !bdd.addGraphOutput( graph, output, &root ) )
+		return false;
+	*pCount = bdd.countModels( root );
+	return true;
+}
+
+bool CountDifferences( const CExpressionGraph& graphA, int outputA, const CExpressionGraph& graphB, int outputB, uint64_t *pCount, CProgress *pProgress )
+{
+	std::vector<char> order;
+	uint32_t rootA, rootB;
+
+	AddBddOrder( graphA, outputA, &order );
+	AddBddOrder( graphB, outputB, &order );
+	AddRemainingVariables( graphA, &order );
+	AddRemainingVariables( graphB, &order );
+
+	CBdd bdd( order );
+	bdd.setProgress( pProgress );
+	if( !bdd.addGraphOutput( graphA, outputA, &rootA ) || !bdd.addGraphOutput( graphB, outputB, &rootB ) )
+		return false;
+	uint32_t difference = bdd.makeXor( rootA, rootB );
+	if( bdd.isOverflowed() )
+		return false;
+	*pCount = bdd.countModels( difference );
+	return true;
+}
@@ -0,0 +1,75 @@
+#pragma once
+#include <stdint.h>
+#include <unordered_map>
+#include <vector>
+#include "expressiongraph.h"
+#include "progress.h"
+
+// Node 0 is constant false and node 1 constant true
+#define BDD_FALSE 0
+#define BDD_TRUE 1
+// Building gives up past this many nodes, callers fall back to tables
+#define BDD_MAX_NODES (1 << 22)
+// New nodes between polls of the progress limits
+#define BDD_PROGRESS_NODES 65536
+
+struct BddNode
+{
+	// Position in the variable order, terminals sit below every variable
+	uint32_t level;
+	uint32_t low;
+	uint32_t high;
+};
+
+// Reduced ordered binary decision diagram. Nodes are unique on (level, low,
+// high), so equal functions are the same node, and operations are cached
+// on their operands. Size depends on the structure of the function and the
+// variable order rather than on the 2^n rows.
+class CBdd
+{
+private:
+	std::vector<BddNode> m_nodes;
+	std::unordered_map<uint64_t, uint32_t> m_uniqueTable;
+	std::unordered_map<uint64_t, uint32_t> m_computed;
+	std::vector<char> m_variables;
+	int m_levels[INPUT_SLOT_COUNT];
+	CProgress *m_pProgress;
+	// Set when the node limit or the progress limits stopped a build
+	bool m_overflow;
+
+	uint32_t makeNode( uint32_t level, uint32_t low, uint32_t high );
+	uint32_t apply( int op, uint32_t a, uint32_t b );
+public:
+	// The order is the variables as given, first at the top
+	CBdd( const std::vector<char>& variables );
+	~CBdd();
+
+	void setProgress( CProgress *pProgress );
+
+	uint32_t makeVariable( char variable );
+	uint32_t makeNot( uint32_t a );
+	uint32_t makeAnd( uint32_t a, uint32_t b );
+	uint32_t makeOr( uint32_t a, uint32_t b );
+	uint32_t makeXor( uint32_t a, uint32_t b );
+
+	// Builds one output of a graph whose variables are all in the order,
+	// returns false if the node limit was hit
+	bool addGraphOutput( const CExpressionGraph& graph, int output, uint32_t *pRoot );
+
+	// Satisfying assignments over every variable of the order
+	uint64_t countModels( uint32_t root ) const;
+
+	inline bool isOverflowed() const { return m_overflow; }
+	inline uint32_t getNodeCount() const { return (uint32_t)m_nodes.size(); }
+	inline const std::vector<char>& getVariables() const { return m_variables; }
+};
+
+// Variables in the order a depth first walk from the outputs meets them,
+// which keeps related variables close together in the BDD
+void GetBddOrder( const CExpressionGraph& graph, int output, std::vector<char> *pOrder );
+
+// Minterms of an output, and the inputs where two outputs disagree (over the
+// union of their variables). Both return false if the BDD got too big or
+// the progress limits stopped it.
+bool CountModels( const CExpressionGraph& graph, int output, uint64_t *pCount, CProgress *pProgress = 0 );
+bool CountDifferences( const CExpressionGraph& graphA, int outputA, const CExpressionGraph& graphB, int outputB, uint64_t *pCount, CProgress *pProgress = 0 );
@@ -0,0 +1,65 @@
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+// Blocking multi-producer multi-consumer queue with a fixed capacity. Pushing
+// into a full queue waits, which is what gives producers backpressure.
+template <typename T>
+class CBoundedQueue
+{
+private:
+	std::mutex m_lock;
+	std::condition_variable m_notEmpty;
+	std::condition_variable m_notFull;
+	std::deque<T> m_items;
+	size_t m_capacity;
+	bool m_closed;
+public:
+	CBoundedQueue( size_t capacity ) {
+		m_capacity = capacity;
+		m_closed = false;
+	}
+
+	// False if the queue was closed
+	bool push( T item )
+	{
+		std::unique_lock<std::mutex> lock( m_lock );
+		m_notFull.wait( lock, [this]()->bool {
+			return m_closed || m_items.size() < m_capacity;
+		} );
+		if( m_closed )
+			return false;
+		m_items.push_back( std::move( item ) );
+		m_notEmpty.notify_one();
+		return true;
+	}
+	// False once the queue is closed and drained
+	bool pop( T *pItem )
+	{
+		std::unique_lock<std::mutex> lock( m_lock );
+		m_notEmpty.wait( lock, [this]()->bool {
+			return m_closed || !m_items.empty();
+		} );
+		if( m_items.empty() )
+			return false;
+		*pItem = std::move( m_items.front() );
+		m_items.pop_front();
+		m_notFull.notify_one();
+		return true;
+	}
+	void close()
+	{
+		std::lock_guard<std::mutex> lock( m_lock );
+		m_closed = true;
+		m_notEmpty.notify_all();
+		m_notFull.notify_all();
+	}
+
+	size_t size()
+	{
+		std::lock_guard<std::mutex> lock( m_lock );
+		return m_items.size();
+	}
+	inline size_t getCapacity() const { return m_capacity; }
+};
@@ -0,0 +1,362 @@
+#include "chunkedtable.h"
+#include <string.h>
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include "util.h"
+
+static const char g_chunkedTableMagic[8] = { 'B', 'A', 'T', 'A', 'B', 'L', 'E', '1' };
+
+static FILE *OpenFile( const std::string& path, const char *pMode )
+{
+	FILE *pFile;
+#ifdef _MSC_VER
+	if( fopen_s( &pFile, path.c_str(), pMode ) != 0 )
+		pFile = 0;
+#else
+	pFile = fopen( path.c_str(), pMode );
+#endif
+	return pFile;
+}
+
+static bool SeekFile( FILE *pFile, uint64_t offset )
+{
+#ifdef _MSC_VER
+	return _fseeki64( pFile, (__int64)offset, SEEK_SET ) == 0;
+#else
+	return fseeko( pFile, (off_t)offset, SEEK_SET ) == 0;
+#endif
+}
+
+// FNV-1a over the inputs and the equations, so a resume can tell whether
+// the file was built from the same thing
+static uint64_t HashFunction( const CExpressionGraph& graph )
+{
+	uint64_t hash = 0xCBF29CE484222325ULL;
+	const std::vector<char>& variables = graph.getUniqueVariables();
+	std::string text( variables.begin(), variables.end() );
+
+	for( int i = 0; i < graph.getOutputCount(); i++ )
+		text += "\n" + graph.getOutputEquation( i );
+	for( unsigned int i = 0; i < text.length(); i++ ) {
+		hash ^= (unsigned char)text[i];
+		hash *= 0x100000001B3ULL;
+	}
+	return hash;
+}
+
+CChunkedTable::CChunkedTable()
+{
+	m_pFile = 0;
+	memset( &m_header, 0, sizeof( m_header ) );
+}
+CChunkedTable::~CChunkedTable() {
+	this->close();
+}
+
+void CChunkedTable::close()
+{
+	if( m_pFile ) {
+		fclose( m_pFile );
+		m_pFile = 0;
+	}
+	memset( &m_header, 0, sizeof( m_header ) );
+	m_variables.clear();
+}
+
+bool CChunkedTable::readHeader( std::string *pError )
+{
+	if( !SeekFile( m_pFile, 0 ) || fread( &m_header, sizeof( m_header ), 1, m_pFile ) != 1 ) {
+		*pError = "Not a table file";
+		return false;
+	}
+	if( memcmp( m_header.magic, g_chunkedTableMagic, sizeof( g_chunkedTableMagic ) ) != 0 ||
+		m_header.variableCount > INPUT_SLOT_COUNT || m_header.outputCount == 0 || m_header.chunkWords == 0 ||
+		m_header.chunkCount * m_header.chunkWords != CTruthTable::getWordCount( m_header.variableCount ) ||
+		m_header.completedChunks > m_header.chunkCount ) {
+		*pError = "Not a table file";
+		return false;
+	}
+	m_variables.assign( m_header.variables, m_header.variables + m_header.variableCount );
+	return true;
+}
+
+bool CChunkedTable::writeHeader()
+{
+	if( !SeekFile( m_pFile, 0 ) || fwrite( &m_header, sizeof( m_header ), 1, m_pFile ) != 1 )
+		return false;
+	return fflush( m_pFile ) == 0;
+}
+
+bool CChunkedTable::build( const CExpressionGraph& graph, const std::string& path, uint64_t memoryBudget, CTaskScheduler& scheduler, uint64_t *pResumedChunks, std::string *pError, CProgress *pProgress )
+{
+	unsigned int variableCount = (unsigned int)graph.getUniqueVariableCount();
+	uint32_t outputCount = (uint32_t)graph.getOutputCount();
+	uint64_t wordCount = CTruthTable::getWordCount( variableCount );
+	uint64_t functionHash = HashFunction( graph );
+
+	this->close();
+	*pResumedChunks = 0;
+
+	// Carry on from an earlier run of the same function
+	m_pFile = OpenFile( path, "r+b" );
+	if( m_pFile )
+	{
+		std::string error;
+		if( this->readHeader( &error ) && m_header.functionHash == functionHash &&
+			m_header.variableCount == variableCount && m_header.outputCount == outputCount )
+			*pResumedChunks = m_header.completedChunks;
+		else
+			this->close();
+	}
+	if( !m_pFile )
+	{
+		m_pFile = OpenFile( path, "w+b" );
+		if( !m_pFile ) {
+			*pError = "Could not open " + path + " for writing";
+			return false;
+		}
+
+		// At least two chunks have to fit, one evaluating and one writing
+		uint64_t chunkWords = std::min( (uint64_t)CHUNKED_TABLE_CHUNK_WORDS, wordCount );
+		while( chunkWords > 1 && 2 * outputCount * chunkWords * sizeof( uint64_t ) > memoryBudget )
+			chunkWords /= 2;
+
+		memcpy( m_header.magic, g_chunkedTableMagic, sizeof( g_chunkedTableMagic ) );
+		m_header.variableCount = variableCount;
+		m_header.outputCount = outputCount;
+		m_header.chunkWords = chunkWords;
+		m_header.chunkCount = wordCount / chunkWords;
+		m_header.completedChunks = 0;
+		m_header.functionHash = functionHash;
+		if( variableCount > 0 )
+			memcpy( m_header.variables, &graph.getUniqueVariables()[0], variableCount );
+		if( !this->writeHeader() ) {
+			*pError = "Could not write " + path;
+			this->close();
+			return false;
+		}
+	}
+	m_variables = graph.getUniqueVariables();
+
+	uint64_t chunkWords = m_header.chunkWords;
+	uint64_t chunkBytes = outputCount * chunkWords * sizeof( uint64_t );
+	uint64_t firstChunk = m_header.completedChunks;
+	if( firstChunk == m_header.chunkCount )
+		return true;
+	uint64_t chunkRows = std::min( chunkWords << 6, (uint64_t)1 << variableCount );
+	if( pProgress )
+		pProgress->setTotalRows( (m_header.chunkCount - firstChunk) * chunkRows );
+
+	// Buffers cycle from the free list to an evaluating task to the writer
+	// and back, so memory stays within the budget however far the
+	// evaluation gets ahead of the disk. One more than the workers keeps
+	// them all busy, more would only queue up chunks a stop can't cancel.
+	uint64_t inFlight = std::min( (uint64_t)scheduler.getThreadCount() + 1, m_header.chunkCount - firstChunk );
+	unsigned int bufferCount = (unsigned int)std::max( (uint64_t)2, std::min( memoryBudget / chunkBytes, inFlight ) );
+	std::vector<std::vector<uint64_t>> buffers( bufferCount, std::vector<uint64_t>( (size_t)(outputCount * chunkWords) ) );
+	std::deque<unsigned int> freeBuffers;
+	std::deque<std::pair<uint64_t, unsigned int>> writeQueue;
+	std::mutex lock;
+	std::condition_variable condition;
+	bool finished = false, failed = false;
+
+	for( unsigned int i = 0; i < bufferCount; i++ )
+		freeBuffers.push_back( i );
+
+	// Chunks finish out of order, the checkpoint only moves past a chunk
+	// once everything before it is written too
+	std::thread writer( [&]() {
+		std::vector<char> written( (size_t)m_header.chunkCount, 0 );
+		uint64_t lastCheckpoint = m_header.completedChunks;
+		bool writeFailed = false;
+
+		while( true )
+		{
+			std::unique_lock<std::mutex> queueLock( lock );
+			condition.wait( queueLock, [&]()->bool {
+				return finished || !writeQueue.empty();
+			} );
+			if( writeQueue.empty() )
+				break;
+			std::pair<uint64_t, unsigned int> item = writeQueue.front();
+			writeQueue.pop_front();
+			queueLock.unlock();
+
+			uint64_t offset = sizeof( ChunkedTableHeader ) + item.first * chunkBytes;
+			bool ok = (SeekFile( m_pFile, offset ) && fwrite( &buffers[item.second][0], (size_t)chunkBytes, 1, m_pFile ) == 1);
+
+			// A chunk that didn't make it to disk holds the checkpoint back
+			// for good, and after any failure the header is left as it was
+			if( ok ) {
+				written[(size_t)item.first] = 1;
+				while( m_header.completedChunks < m_header.chunkCount && written[(size_t)m_header.completedChunks] )
+					m_header.completedChunks++;
+			}
+			if( ok && !writeFailed && m_header.completedChunks - lastCheckpoint >= CHUNKED_TABLE_CHECKPOINT_CHUNKS ) {
+				ok = this->writeHeader();
+				lastCheckpoint = m_header.completedChunks;
+			}
+			if( !ok )
+				writeFailed = true;
+
+			queueLock.lock();
+			if( !ok )
+				failed = true;
+			freeBuffers.push_back( item.second );
+			condition.notify_all();
+		}
+	} );
+
+	CTaskGroup group;
+	for( uint64_t chunk = firstChunk; chunk < m_header.chunkCount; chunk++ )
+	{
+		unsigned int buffer;
+		if( pProgress && pProgress->isStopped() )
+			break;
+		{
+			std::unique_lock<std::mutex> queueLock( lock );
+			condition.wait( queueLock, [&]()->bool {
+				return failed || !freeBuffers.empty();
+			} );
+			if( failed )
+				break;
+			buffer = freeBuffers.front();
+			freeBuffers.pop_front();
+		}
+
+		uint64_t *pBuffer = &buffers[buffer][0];
+		scheduler.submit( group, [&, chunk, buffer, pBuffer]() {
+			// Chunks still waiting when the run stops are dropped unwritten
+			if( pProgress && pProgress->isStopped() ) {
+				std::lock_guard<std::mutex> queueLock( lock );
+				freeBuffers.push_back( buffer );
+				condition.notify_all();
+				return;
+			}
+			graph.evaluateBlock( chunk * chunkWords, chunkWords, pBuffer );
+			if( pProgress )
+				pProgress->addRows( chunkRows );
+			std::lock_guard<std::mutex> queueLock( lock );
+			writeQueue.push_back( std::make_pair( chunk, buffer ) );
+			condition.notify_all();
+		} );
+	}
+	scheduler.wait( group );
+	{
+		std::lock_guard<std::mutex> queueLock( lock );
+		finished = true;
+		condition.notify_all();
+	}
+	writer.join();
+
+	if( failed || !this->writeHeader() ) {
+		*pError = "Could not write " + path;
+		this->close();
+		return false;
+	}
+	return true;
+}
+
+bool CChunkedTable::open( const std::string& path, std::string *pError )
+{
+	this->close();
+	m_pFile = OpenFile( path, "rb" );
+	if( !m_pFile ) {
+		*pError = "Could not open " + path;
+		return false;
+	}
+	if( !this->readHeader( pError ) ) {
+		this->close();
+		return false;
+	}
+	return true;
+}
+
+bool CChunkedTable::readWords( int output, uint64_t startWord, uint64_t wordCount, uint64_t *pWords )
+{
+	uint64_t chunkWords = m_header.chunkWords;
+
+	while( wordCount > 0 )
+	{
+		uint64_t chunk = startWord / chunkWords, inChunk = startWord % chunkWords;
+		uint64_t count = std::min( wordCount, chunkWords - inChunk );
+		uint64_t offset = sizeof( ChunkedTableHeader ) + ((chunk * m_header.outputCount + output) * chunkWords + inChunk) * sizeof( uint64_t );
+		if( !SeekFile( m_pFile, offset ) || fread( pWords, sizeof( uint64_t ), (size_t)count, m_pFile ) != count )
+			return false;
+		pWords += count;
+		startWord += count;
+		wordCount -= count;
+	}
+	return true;
+}
+
+uint64_t CChunkedTable::countOnes( int output )
+{
+	uint64_t wordCount = this->getWordCount(), ones = 0;
+	std::vector<uint64_t> words( (size_t)std::min( wordCount, (uint64_t)CHUNKED_TABLE_STREAM_WORDS ) );
+
+	for( uint64_t start = 0; start < wordCount; start += words.size() )
+	{
+		uint64_t count = std::min( wordCount - start, (uint64_t)words.size() );
+		if( !this->readWords( output, start, count, &words[0] ) )
+			break;
+		for( uint64_t i = 0; i < count; i++ )
+			ones += CountSetBits( words[(size_t)i] );
+	}
+	return ones;
+}
+
+bool CChunkedTable::compare( CChunkedTable& other, int output, int otherOutput, uint64_t *pDifferences, uint64_t *pFirstDifference )
+{
+	uint64_t wordCount = this->getWordCount();
+	size_t blockWords = (size_t)std::min( wordCount, (uint64_t)CHUNKED_TABLE_STREAM_WORDS );
+	std::vector<uint64_t> words( blockWords ), otherWords( blockWords );
+
+	*pDifferences = 0;
+	*pFirstDifference = 0;
+	if( m_variables != other.m_variables )
+		return false;
+
+	for( uint64_t start = 0; start < wordCount; start += blockWords )
+	{
+		uint64_t count = std::min( wordCount - start, (uint64_t)blockWords );
+		if( !this->readWords( output, start, count, &words[0] ) || !other.readWords( otherOutput, start, count, &otherWords[0] ) )
+			return false;
+		for( uint64_t i = 0; i < count; i++ )
+		{
+			uint64_t difference = words[(size_t)i] ^ otherWords[(size_t)i];
+			if( difference == 0 )
+				continue;
+			if( *pDifferences == 0 )
+				*pFirstDifference = ((start + i) << 6) + CountTrailingZeros( difference );
+			*pDifferences += CountSetBits( difference );
+		}
+	}
+	return true;
+}
+
+bool CChunkedTable::exportRaw( FILE *pFile, int output )
+{
+	uint64_t wordCount = this->getWordCount();
+	uint64_t rowsPerWord = std::min( this->getRowCount(), (uint64_t)64 );
+	std::vector<uint64_t> words( (size_t)std::min( wordCount, (uint64_t)CHUNKED_TABLE_STREAM_WORDS ) );
+	std::string line;
+
+	for( uint64_t start = 0; start < wordCount; start += words.size() )
+	{
+		uint64_t count = std::min( wordCount - start, (uint64_t)words.size() );
+		if( !this->readWords( output, start, count, &words[0] ) )
+			return false;
+		line.resize( (size_t)(count * rowsPerWord) );
+		for( uint64_t i = 0; i < count; i++ ) {
+			for( uint64_t j = 0; j < rowsPerWord; j++ )
+				line[(size_t)(i * rowsPerWord + j)] = (char)('0' + ((words[(size_t)i] >> j) & 1));
+		}
+		if( fwrite( line.data(), 1, line.length(), pFile ) != line.length() )
+			return false;
+	}
+	return fputc( '\n', pFile ) != EOF;
+}
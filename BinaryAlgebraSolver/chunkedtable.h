@@ -0,0 +1,75 @@
+#pragma once
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include "expressiongraph.h"
+#include "progress.h"
+#include "scheduler.h"
+
+// Words per output in one chunk unless the memory budget needs less
+#define CHUNKED_TABLE_CHUNK_WORDS 16384
+// Words read at a time when streaming over a finished table
+#define CHUNKED_TABLE_STREAM_WORDS 16384
+// The header is rewritten after this many more chunks are on disk
+#define CHUNKED_TABLE_CHECKPOINT_CHUNKS 64
+#define CHUNKED_TABLE_DEFAULT_BUDGET ((uint64_t)64 << 20)
+
+// Stored at the start of the file as is. completedChunks is the checkpoint,
+// every chunk before it is known to be on disk.
+struct ChunkedTableHeader
+{
+	char magic[8];
+	uint32_t variableCount;
+	uint32_t outputCount;
+	uint64_t chunkWords;
+	uint64_t chunkCount;
+	uint64_t completedChunks;
+	uint64_t functionHash;
+	char variables[32];
+};
+
+// A truth table that lives in a file instead of memory. Building evaluates
+// one chunk of words per task and a writer thread stores them as they come
+// in, with no more chunks in flight than the memory budget allows. Chunk c
+// holds chunkWords words of output 0, then of output 1 and so on. A build
+// that was interrupted carries on from its last checkpoint.
+class CChunkedTable
+{
+private:
+	FILE *m_pFile;
+	ChunkedTableHeader m_header;
+	std::vector<char> m_variables;
+
+	bool readHeader( std::string *pError );
+	bool writeHeader();
+public:
+	CChunkedTable();
+	~CChunkedTable();
+
+	// Creates the file, or resumes it if it holds a partial build of the
+	// same function. pResumedChunks gets how many chunks were already done.
+	// If the progress limits stop it the checkpoint is saved and
+	// isComplete() stays false until a later build finishes it.
+	bool build( const CExpressionGraph& graph, const std::string& path, uint64_t memoryBudget, CTaskScheduler& scheduler, uint64_t *pResumedChunks, std::string *pError, CProgress *pProgress = 0 );
+	bool open( const std::string& path, std::string *pError );
+	void close();
+
+	// Any range of words of one output, across chunk boundaries
+	bool readWords( int output, uint64_t startWord, uint64_t wordCount, uint64_t *pWords );
+
+	uint64_t countOnes( int output );
+	// Tables have to be over the same variables
+	bool compare( CChunkedTable& other, int output, int otherOutput, uint64_t *pDifferences, uint64_t *pFirstDifference );
+	// One line of 0/1 per row, the raw format CPlaFile reads
+	bool exportRaw( FILE *pFile, int output );
+
+	inline bool isComplete() const { return m_header.completedChunks == m_header.chunkCount; }
+	inline int getOutputCount() const { return (int)m_header.outputCount; }
+	inline const std::vector<char>& getUniqueVariables() const { return m_variables; }
+	inline uint64_t getRowCount() const { return (uint64_t)1 << m_header.variableCount; }
+	inline uint64_t getWordCount() const { return CTruthTable::getWordCount( m_header.variableCount ); }
+	inline uint64_t getChunkWords() const { return m_header.chunkWords; }
+	inline uint64_t getChunkCount() const { return m_header.chunkCount; }
+	inline uint64_t getCompletedChunks() const { return m_header.completedChunks; }
+};
@@ -0,0 +1,857 @@
+#include "commandline.h"
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include "aig.h"
+#include "anf.h"
+#include "bdd.h"
+#include "chunkedtable.h"
+#include "equationparser.h"
+#include "equivalence.h"
+#include "expressiongraph.h"
+#include "grader.h"
+#include "karnaughmap.h"
+#include "pipeline.h"
+#include "pla.h"
+#include "progress.h"
+#include "scheduler.h"
+#include "server.h"
+#include "signature.h"
+#include "spectral.h"
+#include "util.h"
+
+// Returns the value following an option, or the fallback if it isn't there
+static std::string GetOption( int argc, char *argv[], const char *pName, std::string fallback )
+{
+	for( int i = 2; i < argc - 1; i++ ) {
+		if( std::string( argv[i] ) == pName )
+			return argv[i + 1];
+	}
+	return fallback;
+}
+
+// True if a flag without a value is present
+static bool HasOption( int argc, char *argv[], const char *pName )
+{
+	for( int i = 2; i < argc; i++ ) {
+		if( std::string( argv[i] ) == pName )
+			return true;
+	}
+	return false;
+}
+
+static CCancellationToken g_cancellationToken;
+
+// The first Ctrl+C stops the run cleanly, a second one kills it as usual
+static void HandleInterrupt( int )
+{
+	g_cancellationToken.cancel();
+	signal( SIGINT, SIG_DFL );
+}
+
+// Limits and reporting shared by the long running modes
+static void SetupProgress( int argc, char *argv[], CProgress *pProgress )
+{
+	pProgress->setCancellationToken( &g_cancellationToken );
+	pProgress->setTimeLimit( strtod( GetOption( argc, argv, "--time-limit", "0" ).c_str(), 0 ) );
+	pProgress->setRowLimit( strtoull( GetOption( argc, argv, "--row-limit", "0" ).c_str(), 0, 10 ) );
+	if( HasOption( argc, argv, "--progress" ) )
+		pProgress->setReportFile( stderr );
+	signal( SIGINT, HandleInterrupt );
+}
+
+static void PrintUsage()
+{
+	printf( "Usage:\n" );
+	printf( "  BinaryAlgebraSolver                     Interactive solver\n" );
+	printf( "  BinaryAlgebraSolver --grade <file>      Check every equation in <file> against the reference\n" );
+	printf( "      --reference <file>                  Reference equation file (default equation.txt)\n" );
+	printf( "  BinaryAlgebraSolver --dedupe <file>     Group the equations in <file> into identical functions\n" );
+	printf( "  BinaryAlgebraSolver --anf <file>        Write every equation in <file> in algebraic normal form\n" );
+	printf( "  BinaryAlgebraSolver --spectrum <file>   Walsh spectrum and properties of every equation in <file>\n" );
+	printf( "  BinaryAlgebraSolver --aig <file>        Build and optimize an and-inverter graph of the equations in <file>\n" );
+	printf( "      --output <file>                     Also write it as ASCII AIGER\n" );
+	printf( "  BinaryAlgebraSolver --pla <file>        Terms of every output of a PLA or raw truth table file\n" );
+	printf( "      --equation <equation>               Compare each output against the equation, ignoring don't cares\n" );
+	printf( "      --kmap                              Also print a K-Map of each output\n" );
+	printf( "  BinaryAlgebraSolver --table <file>      Evaluate the equations in <file> into a table file a chunk at a time\n" );
+	printf( "      --output <file>                     Table file (default <file>.tbl), an interrupted one is resumed\n" );
+	printf( "      --memory <MB>                       Memory for chunks in flight (default 64)\n" );
+	printf( "      --compare <file>                    Compare every output against another table file\n" );
+	printf( "      --export <file>                     Write every output as a raw truth table line\n" );
+	printf( "  BinaryAlgebraSolver --count <file>      Count the minterms of every equation in <file> without a truth table\n" );
+	printf( "      --reference <file>                  Also count the inputs where each differs from this equation\n" );
+	printf( "  BinaryAlgebraSolver --pipeline <file>   Solve every equation in <file> (- for stdin)\n" );
+	printf( "      --output <file>                     Write the reports to <file> instead of stdout\n" );
+	printf( "  BinaryAlgebraSolver --server            Answer JSON lines requests on stdin/stdout\n" );
+	printf( "      --socket <path>                     Listen on a Unix domain socket instead\n" );
+	printf( "      --threads <n>                       Worker threads (default all cores)\n" );
+	printf( "  --stats[=json]                          With any mode, print counters and phase timings to stderr on exit\n" );
+	printf( "  --time-limit <s>, --row-limit <n>       Stop --grade, --table and --count early with partial results\n" );
+	printf( "  --progress                              Report rows done, rows/s and the ETA to stderr (Ctrl+C also stops cleanly)\n" );
+}
+
+static int RunGrade( int argc, char *argv[] )
+{
+	std::vector<std::string> referenceLines, candidates;
+	std::vector<GradeResult> results;
+	std::string referencePath, candidatePath;
+	CGrader grader;
+	int parseError;
+
+	if( argc < 3 ) {
+		PrintUsage();
+		return 5;
+	}
+	candidatePath = argv[2];
+	referencePath = GetOption( argc, argv, "--reference", "equation.txt" );
+
+	if( !ReadLines( referencePath, &referenceLines ) || referenceLines.size() == 0 ) {
+		printf( "ERROR: %s not found containing comparison function!\n", referencePath.c_str() );
+		return 6;
+	}
+	if( !grader.setReference( referenceLines[0], &parseError ) ) {
+		printf( "ERROR: Could not parse comparison equation\n" );
+		return 7;
+	}
+	if( !ReadLines( candidatePath, &candidates ) ) {
+		printf( "ERROR: %s not found containing candidate equations!\n", candidatePath.c_str() );
+		return 6;
+	}
+
+	CTaskScheduler scheduler( (unsigned int)strtol( GetOption( argc, argv, "--threads", "0" ).c_str(), 0, 10 ) );
+	const CTruthTable& reference = grader.getReferenceTable();
+	printf( " > Comparison equation: %s (%u variables)\n", grader.getReferenceEquation().c_str(), reference.getVariableCount() );
+
+	CProgress progress( "grade" );
+	SetupProgress( argc, argv, &progress );
+	grader.grade( candidates, &results, scheduler, &progress );
+	progress.finish();
+
+	int equalCount = 0, nequalCount = 0, errorCount = 0, incompleteCount = 0, blankCount = 0;
+	for( unsigned int i = 0; i < results.size(); i++ )
+	{
+		switch( results[i].result )
+		{
+		case GRADE_RESULT_BLANK:
+			blankCount++;
+			break;
+		case GRADE_RESULT_EQUAL:
+			printf( "Candidate %u:\t EQUAL\n", i );
+			equalCount++;
+			break;
+		case GRADE_RESULT_NEQUAL:
+			printf( "Candidate %u:\t NEQUAL (mismatches: %llu, %s: %s)\n", i, (unsigned long long)results[i].mismatchCount, (results[i].firstMismatchKnown ? "first" : "a mismatch"),
+				ConvertIntToBinary( (int)results[i].firstMismatch, reference.getVariableCount() ).c_str() );
+			nequalCount++;
+			break;
+		case GRADE_RESULT_INCOMPLETE:
+			printf( "Candidate %u:\t INCOMPLETE (no mismatch in the first %llu rows)\n", i, (unsigned long long)results[i].rowsChecked );
+			incompleteCount++;
+			break;
+		case GRADE_RESULT_VARIABLES:
+			printf( "Candidate %u:\t ERROR (variables not in comparison equation)\n", i );
+			errorCount++;
+			break;
+		case GRADE_RESULT_PARSE_ERROR:
+		default:
+			printf( "Candidate %u:\t ERROR (invalid equation)\n", i );
+			errorCount++;
+			break;
+		}
+	}
+	printf( "Graded %u candidates on %u threads: %d equal, %d not equal, %d errors\n", (unsigned int)results.size() - blankCount, scheduler.getThreadCount(), equalCount, nequalCount, errorCount );
+	if( incompleteCount > 0 ) {
+		printf( "Stopped early (%s), %d candidates incomplete\n", GetProgressStateName( progress.getState() ), incompleteCount );
+		return 9;
+	}
+
+	return 0;
+}
+
+static int RunDedupe( int argc, char *argv[] )
+{
+	std::vector<std::string> equations;
+	CEquivalenceClasses classes;
+
+	if( argc < 3 ) {
+		PrintUsage();
+		return 5;
+	}
+	if( !ReadLines( argv[2], &equations ) ) {
+		printf( "ERROR: %s not found containing equations!\n", argv[2] );
+		return 6;
+	}
+
+	CTaskScheduler scheduler( (unsigned int)strtol( GetOption( argc, argv, "--threads", "0" ).c_str(), 0, 10 ) );
+	classes.classify( equations, scheduler );
+
+	// Members of each class in input order
+	std::vector<std::vector<int>> members( classes.getClassCount() );
+	int errorCount = 0, blankCount = 0;
+	for( unsigned int i = 0; i < equations.size(); i++ ) {
+		if( IsBlankLine( equations[i] ) )
+			blankCount++;
+		else if( classes.getClass( i ) == -1 )
+			errorCount++;
+		else
+			members[classes.getClass( i )].push_back( i );
+	}
+	for( unsigned int i = 0; i < members.size(); i++ )
+	{
+		printf( "Class %u (%u equations, e.g. %s): ", i, (unsigned int)members[i].size(), equations[members[i][0]].c_str() );
+		for( auto it = members[i].begin(); it != members[i].end(); it++ ) {
+			printf( "%d", (*it) );
+			if( it + 1 != members[i].end() )
+				printf( ", " );
+		}
+		printf( "\n" );
+	}
+	printf( "%u equations in %d classes (%d signature buckets, %llu exact checks, %d invalid)\n", (unsigned int)equations.size() - blankCount,
+		classes.getClassCount(), classes.getBucketCount(), (unsigned long long)classes.getExactCheckCount(), errorCount );
+
+	return 0;
+}
+
+static int RunAnf( int argc, char *argv[] )
+{
+	std::vector<std::string> equations;
+	std::vector<CTruthTable> tables;
+	CTruthTable anf;
+
+	if( argc < 3 ) {
+		PrintUsage();
+		return 5;
+	}
+	if( !ReadLines( argv[2], &equations ) ) {
+		printf( "ERROR: %s not found containing equations!\n", argv[2] );
+		return 6;
+	}
+
+	for( unsigned int i = 0; i < equations.size(); i++ )
+	{
+		CEquationParser parser;
+		CExpressionGraph graph;
+		int parseError;
+
+		if( IsBlankLine( equations[i] ) )
+			continue;
+		printf( "Equation %u: ", i );
+		if( !parser.parse( equations[i], &parseError ) || !graph.addEquation( parser, &parseError ) ) {
+			printf( "ERROR: Invalid equation\n" );
+			continue;
+		}
+		graph.evaluateTables( &tables );
+		ComputeAnf( tables[0], &anf );
+
+		uint64_t termCount = anf.countOnes();
+		printf( "%s\n", parser.getCleanEquation().c_str() );
+		if( termCount > ANF_MAX_FORMAT_TERMS )
+			printf( "ANF: %llu terms, degree %u\n", (unsigned long long)termCount, GetAnfDegree( anf ) );
+		else
+			printf( "ANF: %s (%llu terms, degree %u)\n", FormatAnf( anf ).c_str(), (unsigned long long)termCount, GetAnfDegree( anf ) );
+	}
+
+	return 0;
+}
+
+static int RunSpectrum( int argc, char *argv[] )
+{
+	static const char *unateNames[] = { "independent", "positive", "negative", "binate" };
+	std::vector<std::string> equations;
+	std::vector<CTruthTable> tables;
+	std::vector<int32_t> spectrum;
+	FunctionProperties properties;
+
+	if( argc < 3 ) {
+		PrintUsage();
+		return 5;
+	}
+	if( !ReadLines( argv[2], &equations ) ) {
+		printf( "ERROR: %s not found containing equations!\n", argv[2] );
+		return 6;
+	}
+
+	CTaskScheduler scheduler( (unsigned int)strtol( GetOption( argc, argv, "--threads", "0" ).c_str(), 0, 10 ) );
+	for( unsigned int i = 0; i < equations.size(); i++ )
+	{
+		CEquationParser parser;
+		CExpressionGraph graph;
+		int parseError;
+
+		if( IsBlankLine( equations[i] ) )
+			continue;
+		printf( "Equation %u: ", i );
+		if( !parser.parse( equations[i], &parseError ) || !graph.addEquation( parser, &parseError ) ) {
+			printf( "ERROR: Invalid equation\n" );
+			continue;
+		}
+		graph.evaluateCofactors( &tables, scheduler );
+		AnalyzeFunction( tables[0], &spectrum, &properties, scheduler );
+
+		const std::vector<char>& variables = graph.getUniqueVariables();
+		unsigned int variableCount = (unsigned int)variables.size();
+		printf( "%s (%s)\n", parser.getCleanEquation().c_str(), std::string( variables.begin(), variables.end() ).c_str() );
+		printf( " Ones: %llu of %llu (%s)\n", (unsigned long long)properties.ones, (unsigned long long)tables[0].getRowCount(), (properties.balanced ? "balanced" : "unbalanced") );
+		if( variableCount <= SPECTRUM_MAX_LIST_VARIABLES ) {
+			printf( " Walsh spectrum: " );
+			for( unsigned int j = 0; j < spectrum.size(); j++ )
+				printf( "%d%s", spectrum[j], (j + 1 < spectrum.size() ? ", " : "\n") );
+		}
+		printf( " Largest coefficient: W(%s) = %d\n", ConvertIntToBinary( (int)properties.maxWalshIndex, variableCount ).c_str(), spectrum[(size_t)properties.maxWalshIndex] );
+		printf( " Linear: %s, affine: %s, nonlinearity: %llu\n", (properties.linear ? "yes" : "no"), (properties.affine ? "yes" : "no"), (unsigned long long)properties.nonlinearity );
+		printf( " Var\t| Influence\t| Unate\n" );
+		for( unsigned int j = 0; j < variableCount; j++ )
+			printf( " %c\t| %.4f\t| %s\n", variables[j], properties.variables[j].influence, unateNames[properties.variables[j].unateness] );
+		if( properties.totallySymmetric )
+			printf( " Symmetric in all variables\n" );
+		else
+		{
+			std::string pairs;
+			for( unsigned int j = 0; j < variableCount; j++ ) {
+				for( unsigned int k = j + 1; k < variableCount; k++ ) {
+					if( !properties.symmetricPairs[j * variableCount + k] )
+						continue;
+					if( !pairs.empty() )
+						pairs += ", ";
+					pairs += std::string( 1, variables[j] ) + variables[k];
+				}
+			}
+			printf( " Symmetric pairs: %s\n", (pairs.empty() ? "none" : pairs.c_str()) );
+		}
+	}
+
+	return 0;
+}
+
+static int RunAig( int argc, char *argv[] )
+{
+	std::vector<std::string> equations;
+	std::string outputPath;
+	CExpressionGraph graph;
+	CAig aig, optimized;
+	int errorCount = 0;
+
+	if( argc < 3 ) {
+		PrintUsage();
+		return 5;
+	}
+	if( !ReadLines( argv[2], &equations ) ) {
+		printf( "ERROR: %s not found containing equations!\n", argv[2] );
+		return 6;
+	}
+	outputPath = GetOption( argc, argv, "--output", "" );
+
+	// Every equation is an output of one shared graph
+	for( unsigned int i = 0; i < equations.size(); i++ )
+	{
+		CEquationParser parser;
+		int parseError;
+		if( IsBlankLine( equations[i] ) )
+			continue;
+		if( !parser.parse( equations[i], &parseError ) || !graph.addEquation( parser, &parseError ) ) {
+			printf( "Equation %u: ERROR: Invalid equation\n", i );
+			errorCount++;
+		}
+	}
+	if( graph.getOutputCount() == 0 ) {
+		printf( "ERROR: No valid equations\n" );
+		return 7;
+	}
+
+	aig.addGraph( graph );
+	printf( "%d outputs over %d inputs (%d invalid)\n", aig.getOutputCount(), aig.getUniqueVariableCount(), errorCount );
+	printf( " Lowered:   %u ANDs, depth %u\n", aig.getAndCount(), aig.getDepth() );
+	optimized = aig;
+	optimized.optimize();
+	printf( " Optimized: %u ANDs, depth %u\n", optimized.getAndCount(), optimized.getDepth() );
+
+	// Check the optimized outputs against the lowered ones in one graph
+	CAig check = aig;
+	int firstOptimized = check.addAig( optimized );
+	for( int i = 0; i < aig.getOutputCount(); i++ )
+	{
+		EquivalenceResult result;
+		CheckEquivalence( check, i, firstOptimized + i, &result );
+		if( !result.equal ) {
+			printf( "ERROR: Optimization changed output %d (%s)\n", i, aig.getOutputName( i ).c_str() );
+			return 8;
+		}
+	}
+
+	if( outputPath != "" )
+	{
+		FILE *pOutput;
+#ifdef _MSC_VER
+		fopen_s( &pOutput, outputPath.c_str(), "w" );
+#else
+		pOutput = fopen( outputPath.c_str(), "w" );
+#endif
+		if( !pOutput ) {
+			printf( "ERROR: Could not open %s for writing\n", outputPath.c_str() );
+			return 6;
+		}
+		optimized.writeAiger( pOutput );
+		fclose( pOutput );
+		printf( "Wrote %s\n", outputPath.c_str() );
+	}
+
+	return 0;
+}
+
+// Prints a term list from a table, term numbers are rows
+static void PrintTableTerms( const char *pLabel, char symbol, const CTruthTable& terms, const CTruthTable& donkeys )
+{
+	std::vector<int> termList, donkeyList;
+
+	terms.getMinterms( &termList );
+	donkeys.getMinterms( &donkeyList );
+	printf( " %s: %c(", pLabel, symbol );
+	for( unsigned int i = 0; i < termList.size(); i++ )
+		printf( "%d%s", termList[i], (i + 1 < termList.size() ? ", " : "") );
+	if( donkeyList.size() > 0 ) {
+		printf( ") + d(" );
+		for( unsigned int i = 0; i < donkeyList.size(); i++ )
+			printf( "%d%s", donkeyList[i], (i + 1 < donkeyList.size() ? ", " : "") );
+	}
+	printf( ")\n" );
+}
+
+static int RunPla( int argc, char *argv[] )
+{
+	static const char *typeNames[] = { "f", "fd", "fr", "fdr" };
+	std::string error, equation;
+	CPlaFile pla;
+	CEquationParser parser;
+	CExpressionGraph graph;
+	bool showKmap = false;
+
+	if( argc < 3 ) {
+		PrintUsage();
+		return 5;
+	}
+	if( !pla.load( argv[2], &error ) ) {
+		printf( "ERROR: %s\n", error.c_str() );
+		return 6;
+	}
+	equation = GetOption( argc, argv, "--equation", "" );
+	showKmap = HasOption( argc, argv, "--kmap" );
+
+	const std::vector<char>& variables = pla.getVariables();
+	if( pla.isRaw() )
+		printf( "%d outputs over %d inputs (raw tables)\n", pla.getOutputCount(), pla.getInputCount() );
+	else
+		printf( "%d outputs over %d inputs (%llu cubes, type %s)\n", pla.getOutputCount(), pla.getInputCount(), (unsigned long long)pla.getCubeCount(), typeNames[pla.getType()] );
+	if( !pla.isRaw() ) {
+		printf( " Inputs:" );
+		for( int i = 0; i < pla.getInputCount(); i++ )
+			printf( " %c=%s", variables[i], pla.getInputName( i ).c_str() );
+		printf( "\n" );
+	}
+
+	// The equation can only use the PLA's inputs, it is evaluated over all of them
+	if( equation != "" )
+	{
+		int parseError;
+		if( !parser.parse( equation, &parseError ) || !graph.addEquation( parser, &parseError ) ) {
+			printf( "ERROR: Invalid equation\n" );
+			return 7;
+		}
+		const std::vector<char>& equationVariables = graph.getUniqueVariables();
+		for( unsigned int i = 0; i < equationVariables.size(); i++ ) {
+			if( std::find( variables.begin(), variables.end(), equationVariables[i] ) == variables.end() ) {
+				printf( "ERROR: %c is not an input of the PLA\n", equationVariables[i] );
+				return 7;
+			}
+		}
+	}
+
+	int mismatches = 0;
+	for( int i = 0; i < pla.getOutputCount(); i++ )
+	{
+		const CTruthTable& onSet = pla.getOnSet( i );
+		const CTruthTable& dcSet = pla.getDcSet( i );
+		CTruthTable minterms( variables ), offSet( variables );
+		uint64_t mask = onSet.getLastWordMask();
+
+		// Don't cares win over the on set so they are listed only once
+		for( uint64_t j = 0; j < onSet.getWordCount(); j++ ) {
+			minterms.setWord( j, onSet.getWord( j ) & ~dcSet.getWord( j ) & mask );
+			offSet.setWord( j, ~(onSet.getWord( j ) | dcSet.getWord( j )) & mask );
+		}
+
+		printf( "Output %d (%s): %llu on, %llu don't care\n", i, pla.getOutputName( i ).c_str(), (unsigned long long)minterms.countOnes(), (unsigned long long)dcSet.countOnes() );
+		if( pla.getInputCount() <= PLA_MAX_LIST_INPUTS ) {
+			PrintTableTerms( "Minterms", 'm', minterms, dcSet );
+			PrintTableTerms( "Maxterms", 'M', offSet, dcSet );
+		}
+
+		if( equation != "" )
+		{
+			std::vector<uint64_t> values( graph.getNodeCount() );
+			uint64_t slots[INPUT_SLOT_COUNT] = { 0 };
+			bool found = false;
+			for( uint64_t j = 0; j < onSet.getWordCount() && !found; j++ )
+			{
+				CTruthTable::fillInputSlots( variables, j, slots );
+				graph.evaluateWord( slots, &values[0] );
+				uint64_t difference = (values[graph.getOutput( 0 )] ^ onSet.getWord( j )) & ~dcSet.getWord( j ) & mask;
+				if( difference ) {
+					uint64_t row = (j << 6) + CountTrailingZeros( difference );
+					printf( " Differs from %s at %s (equation gives %d)\n", parser.getCleanEquation().c_str(),
+						ConvertIntToBinary( (int)row, pla.getInputCount() ).c_str(), (int)((values[graph.getOutput( 0 )] >> (row & 63)) & 1) );
+					found = true;
+				}
+			}
+			if( found )
+				mismatches++;
+			else
+				printf( " Matches %s\n", parser.getCleanEquation().c_str() );
+		}
+
+		if( showKmap && pla.getInputCount() >= 2 && pla.getInputCount() <= PLA_MAX_KMAP_INPUTS )
+		{
+			CKarnaughMap kmap;
+			int columnCount = (pla.getInputCount() + 1) / 2;
+			kmap.m_uniqueVariables = variables;
+			minterms.getMinterms( &kmap.m_minTerms );
+			offSet.getMinterms( &kmap.m_maxTerms );
+			dcSet.getMinterms( &kmap.m_donkeyTerms );
+			kmap.setColumnVars( std::string( variables.begin(), variables.begin() + columnCount ) );
+			kmap.setRowVars( std::string( variables.begin() + columnCount, variables.end() ) );
+			kmap.print();
+		}
+	}
+
+	return (mismatches > 0 ? 8 : 0);
+}
+
+static int RunTable( int argc, char *argv[] )
+{
+	std::vector<std::string> equations;
+	std::string tablePath, comparePath, exportPath, error;
+	CExpressionGraph graph;
+	CChunkedTable table;
+	uint64_t memoryBudget, resumedChunks;
+
+	if( argc < 3 ) {
+		PrintUsage();
+		return 5;
+	}
+	if( !ReadLines( argv[2], &equations ) ) {
+		printf( "ERROR: %s not found containing equations!\n", argv[2] );
+		return 6;
+	}
+	tablePath = GetOption( argc, argv, "--output", std::string( argv[2] ) + ".tbl" );
+	comparePath = GetOption( argc, argv, "--compare", "" );
+	exportPath = GetOption( argc, argv, "--export", "" );
+	memoryBudget = strtoull( GetOption( argc, argv, "--memory", "0" ).c_str(), 0, 10 ) << 20;
+	if( memoryBudget == 0 )
+		memoryBudget = CHUNKED_TABLE_DEFAULT_BUDGET;
+
+	for( unsigned int i = 0; i < equations.size(); i++ )
+	{
+		CEquationParser parser;
+		int parseError;
+		if( IsBlankLine( equations[i] ) )
+			continue;
+		if( !parser.parse( equations[i], &parseError ) || !graph.addEquation( parser, &parseError ) ) {
+			printf( "ERROR: Equation %u is invalid\n", i );
+			return 7;
+		}
+	}
+	if( graph.getOutputCount() == 0 ) {
+		printf( "ERROR: No valid equations\n" );
+		return 7;
+	}
+
+	CTaskScheduler scheduler( (unsigned int)strtol( GetOption( argc, argv, "--threads", "0" ).c_str(), 0, 10 ) );
+	CProgress progress( "table" );
+	SetupProgress( argc, argv, &progress );
+	if( !table.build( graph, tablePath, memoryBudget, scheduler, &resumedChunks, &error, &progress ) ) {
+		printf( "ERROR: %s\n", error.c_str() );
+		return 6;
+	}
+	progress.finish();
+	if( !table.isComplete() ) {
+		printf( "Stopped early (%s) after %llu of %llu chunks, run again to resume\n", GetProgressStateName( progress.getState() ),
+			(unsigned long long)table.getCompletedChunks(), (unsigned long long)table.getChunkCount() );
+		return 9;
+	}
+	const std::vector<char>& variables = table.getUniqueVariables();
+	printf( "%s: %d outputs over %d inputs, %llu chunks of %llu words", tablePath.c_str(), table.getOutputCount(), (int)variables.size(),
+		(unsigned long long)table.getChunkCount(), (unsigned long long)table.getChunkWords() );
+	if( resumedChunks > 0 )
+		printf( " (resumed after %llu)", (unsigned long long)resumedChunks );
+	printf( "\n" );
+	for( int i = 0; i < table.getOutputCount(); i++ )
+		printf( " Output %d: %llu of %llu rows set\n", i, (unsigned long long)table.countOnes( i ), (unsigned long long)table.getRowCount() );
+
+	if( comparePath != "" )
+	{
+		CChunkedTable other;
+		if( !other.open( comparePath, &error ) ) {
+			printf( "ERROR: %s\n", error.c_str() );
+			return 6;
+		}
+		if( !other.isComplete() || other.getUniqueVariables() != variables || other.getOutputCount() != table.getOutputCount() ) {
+			printf( "ERROR: %s is not a finished table of the same shape\n", comparePath.c_str() );
+			return 7;
+		}
+		for( int i = 0; i < table.getOutputCount(); i++ )
+		{
+			uint64_t differences, firstDifference;
+			if( !table.compare( other, i, i, &differences, &firstDifference ) ) {
+				printf( "ERROR: Could not read %s\n", comparePath.c_str() );
+				return 6;
+			}
+			if( differences == 0 )
+				printf( " Output %d: EQUAL\n", i );
+			else
+				printf( " Output %d: NEQUAL (mismatches: %llu, first: %s)\n", i, (unsigned long long)differences,
+					ConvertIntToBinary( (int)firstDifference, (unsigned int)variables.size() ).c_str() );
+		}
+	}
+
+	if( exportPath != "" )
+	{
+		FILE *pOutput;
+#ifdef _MSC_VER
+		fopen_s( &pOutput, exportPath.c_str(), "w" );
+#else
+		pOutput = fopen( exportPath.c_str(), "w" );
+#endif
+		if( !pOutput ) {
+			printf( "ERROR: Could not open %s for writing\n", exportPath.c_str() );
+			return 6;
+		}
+		for( int i = 0; i < table.getOutputCount(); i++ )
+			table.exportRaw( pOutput, i );
+		fclose( pOutput );
+		printf( "Wrote %s\n", exportPath.c_str() );
+	}
+
+	return 0;
+}
+
+// Words between progress updates in the row by row counts
+#define COUNT_PROGRESS_WORDS 1024
+
+// Row by row fallback for when the BDD gets too big, false if the progress
+// limits stopped it first
+static bool CountModelsByRows( const CExpressionGraph& graph, uint64_t *pCount, CProgress *pProgress )
+{
+	const std::vector<char>& variables = graph.getUniqueVariables();
+	std::vector<uint64_t> values( graph.getNodeCount() );
+	uint64_t slots[INPUT_SLOT_COUNT] = { 0 };
+
+	uint64_t wordCount = CTruthTable::getWordCount( (unsigned int)variables.size() );
+	uint64_t mask = CTruthTable::getLastWordMask( (unsigned int)variables.size() );
+
+	*pCount = 0;
+	for( uint64_t i = 0; i < wordCount; i++ )
+	{
+		if( i % COUNT_PROGRESS_WORDS == 0 && i != 0 && !pProgress->addRows( COUNT_PROGRESS_WORDS * 64 ) )
+			return false;
+		CTruthTable::fillInputSlots( variables, i, slots );
+		graph.evaluateWord( slots, &values[0] );
+		*pCount += CountSetBits( values[graph.getOutput( 0 )] & mask );
+	}
+	pProgress->addRows( ((uint64_t)1 << variables.size()) - ((wordCount - 1) / COUNT_PROGRESS_WORDS) * COUNT_PROGRESS_WORDS * 64 );
+	return true;
+}
+
+// Same over the union of both graphs' variables
+static bool CountDifferencesByRows( const CExpressionGraph& graphA, const CExpressionGraph& graphB, uint64_t *pDifferences, CProgress *pProgress )
+{
+	std::vector<char> variables = graphA.getUniqueVariables();
+	std::vector<uint64_t> valuesA( graphA.getNodeCount() ), valuesB( graphB.getNodeCount() );
+	uint64_t slots[INPUT_SLOT_COUNT] = { 0 };
+
+	variables.insert( variables.end(), graphB.getUniqueVariables().begin(), graphB.getUniqueVariables().end() );
+	std::sort( variables.begin(), variables.end() );
+	variables.erase( std::unique( variables.begin(), variables.end() ), variables.end() );
+
+	uint64_t wordCount = CTruthTable::getWordCount( (unsigned int)variables.size() );
+	uint64_t mask = CTruthTable::getLastWordMask( (unsigned int)variables.size() );
+
+	*pDifferences = 0;
+	for( uint64_t i = 0; i < wordCount; i++ )
+	{
+		if( i % COUNT_PROGRESS_WORDS == 0 && i != 0 && !pProgress->addRows( COUNT_PROGRESS_WORDS * 64 ) )
+			return false;
+		CTruthTable::fillInputSlots( variables, i, slots );
+		graphA.evaluateWord( slots, &valuesA[0] );
+		graphB.evaluateWord( slots, &valuesB[0] );
+		*pDifferences += CountSetBits( (valuesA[graphA.getOutput( 0 )] ^ valuesB[graphB.getOutput( 0 )]) & mask );
+	}
+	pProgress->addRows( ((uint64_t)1 << variables.size()) - ((wordCount - 1) / COUNT_PROGRESS_WORDS) * COUNT_PROGRESS_WORDS * 64 );
+	return true;
+}
+
+static int RunCount( int argc, char *argv[] )
+{
+	std::vector<std::string> equations, referenceLines;
+	std::string referencePath;
+	CEquationParser referenceParser;
+	CExpressionGraph referenceGraph;
+	int parseError;
+
+	if( argc < 3 ) {
+		PrintUsage();
+		return 5;
+	}
+	if( !ReadLines( argv[2], &equations ) ) {
+		printf( "ERROR: %s not found containing equations!\n", argv[2] );
+		return 6;
+	}
+	referencePath = GetOption( argc, argv, "--reference", "" );
+	if( referencePath != "" )
+	{
+		if( !ReadLines( referencePath, &referenceLines ) || referenceLines.size() == 0 ) {
+			printf( "ERROR: %s not found containing comparison function!\n", referencePath.c_str() );
+			return 6;
+		}
+		if( !referenceParser.parse( referenceLines[0], &parseError ) || !referenceGraph.addEquation( referenceParser, &parseError ) ) {
+			printf( "ERROR: Could not parse comparison equation\n" );
+			return 7;
+		}
+	}
+
+	// A BDD count covers every row at once and adds them when it's done, the
+	// row by row fallbacks add them as they go
+	CProgress progress( "count" );
+	SetupProgress( argc, argv, &progress );
+	bool stopped = false;
+	for( unsigned int i = 0; i < equations.size() && !stopped; i++ )
+	{
+		CEquationParser parser;
+		CExpressionGraph graph;
+		uint64_t count;
+
+		// Only stopped if a limit was reached with equations still to go
+		if( progress.isStopped() ) {
+			stopped = true;
+			break;
+		}
+		if( IsBlankLine( equations[i] ) )
+			continue;
+		printf( "Equation %u: ", i );
+		if( !parser.parse( equations[i], &parseError ) || !graph.addEquation( parser, &parseError ) ) {
+			printf( "ERROR: Invalid equation\n" );
+			continue;
+		}
+		uint64_t rowCount = (uint64_t)1 << graph.getUniqueVariableCount();
+		if( CountModels( graph, 0, &count, &progress ) )
+			progress.addRows( rowCount );
+		else if( progress.isStopped() || !CountModelsByRows( graph, &count, &progress ) ) {
+			printf( "STOPPED\n" );
+			stopped = true;
+			break;
+		}
+		printf( "%s: %llu of %llu minterms", parser.getCleanEquation().c_str(), (unsigned long long)count, (unsigned long long)rowCount );
+
+		if( referencePath != "" )
+		{
+			if( CountDifferences( graph, 0, referenceGraph, 0, &count, &progress ) )
+				progress.addRows( rowCount );
+			else if( progress.isStopped() || !CountDifferencesByRows( graph, referenceGraph, &count, &progress ) ) {
+				printf( ", STOPPED\n" );
+				stopped = true;
+				break;
+			}
+			printf( ", %llu inputs differ from %s", (unsigned long long)count, referenceParser.getCleanEquation().c_str() );
+		}
+		printf( "\n" );
+	}
+	progress.finish();
+	if( stopped ) {
+		printf( "Stopped early (%s)\n", GetProgressStateName( progress.getState() ) );
+		return 9;
+	}
+
+	return 0;
+}
+
+static int RunServer( int argc, char *argv[] )
+{
+	CSolverServer server( (unsigned int)strtol( GetOption( argc, argv, "--threads", "0" ).c_str(), 0, 10 ) );
+	std::string socketPath = GetOption( argc, argv, "--socket", "" );
+	int result;
+
+	if( socketPath != "" )
+		result = server.serveSocket( socketPath );
+	else
+		result = server.serveStream( stdin, stdout );
+	server.printSummary( stderr );
+
+	return result;
+}
+
+static int RunPipeline( int argc, char *argv[] )
+{
+	std::string inputPath, outputPath;
+	FILE *pInput, *pOutput;
+	CPipeline pipeline;
+
+	if( argc < 3 ) {
+		PrintUsage();
+		return 5;
+	}
+	inputPath = argv[2];
+	outputPath = GetOption( argc, argv, "--output", "" );
+
+	pInput = (inputPath == "-" ? stdin : fopen( inputPath.c_str(), "r" ));
+	if( !pInput ) {
+		printf( "ERROR: %s not found containing equations!\n", inputPath.c_str() );
+		return 6;
+	}
+	pOutput = (outputPath == "" ? stdout : fopen( outputPath.c_str(), "w" ));
+	if( !pOutput ) {
+		printf( "ERROR: Could not open %s for writing\n", outputPath.c_str() );
+		if( pInput != stdin )
+			fclose( pInput );
+		return 6;
+	}
+
+	pipeline.run( pInput, pOutput );
+	pipeline.printStats( stderr );
+
+	if( pInput != stdin )
+		fclose( pInput );
+	if( pOutput != stdout )
+		fclose( pOutput );
+	return 0;
+}
+
+int RunCommandLine( int argc, char *argv[] )
+{
+	std::string command = argv[1];
+
+	if( command == "--grade" )
+		return RunGrade( argc, argv );
+	else if( command == "--dedupe" )
+		return RunDedupe( argc, argv );
+	else if( command == "--anf" )
+		return RunAnf( argc, argv );
+	else if( command == "--spectrum" )
+		return RunSpectrum( argc, argv );
+	else if( command == "--aig" )
+		return RunAig( argc, argv );
+	else if( command == "--pla" )
+		return RunPla( argc, argv );
+	else if( command == "--table" )
+		return RunTable( argc, argv );
+	else if( command == "--count" )
+		return RunCount( argc, argv );
+	else if( command == "--pipeline" )
+		return RunPipeline( argc, argv );
+	else if( command == "--server" )
+		return RunServer( argc, argv );
+
+	PrintUsage();
+	return 5;
+}
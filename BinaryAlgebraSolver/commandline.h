@@ -0,0 +1,4 @@
+#pragma once
+
+// Non-interactive modes, selected by the first command line argument
+int RunCommandLine( int argc, char *argv[] );
@@ -0,0 +1,85 @@
+#include "compiledequation.h"
+#include <string.h>
+#include "equationparser.h"
+
+CCompiledEquation::CCompiledEquation() {
+	m_compiled = false;
+}
+CCompiledEquation::~CCompiledEquation() {
+}
+
+bool CCompiledEquation::compile( const std::string& equation, int *pError )
+{
+	CEquationParser parser;
+
+	m_compiled = false;
+	m_graph = CExpressionGraph();
+	m_equation.clear();
+
+	if( !parser.parse( equation, pError ) || !m_graph.addEquation( parser, pError ) )
+		return false;
+	m_equation = parser.getCleanEquation();
+	m_compiled = true;
+	return true;
+}
+
+bool CCompiledEquation::evaluate( uint64_t input ) const
+{
+	CEvaluationContext context( *this );
+	return context.evaluate( input );
+}
+void CCompiledEquation::evaluate( const uint64_t *pInputs, size_t count, uint8_t *pOutputs ) const
+{
+	CEvaluationContext context( *this );
+	context.evaluate( pInputs, count, pOutputs );
+}
+
+CEvaluationContext::CEvaluationContext( const CCompiledEquation& equation )
+{
+	m_pEquation = &equation;
+	m_values.resize( equation.getGraph().getNodeCount() );
+	memset( m_slots, 0, sizeof( m_slots ) );
+}
+CEvaluationContext::~CEvaluationContext() {
+}
+
+uint64_t CEvaluationContext::evaluateWord( const uint64_t *pSlots )
+{
+	const CExpressionGraph& graph = m_pEquation->getGraph();
+	if( !m_pEquation->isCompiled() )
+		return 0;
+	graph.evaluateWord( pSlots, &m_values[0] );
+	return m_values[graph.getOutput( 0 )];
+}
+
+bool CEvaluationContext::evaluate( uint64_t input )
+{
+	uint8_t output;
+	this->evaluate( &input, 1, &output );
+	return output != 0;
+}
+
+void CEvaluationContext::evaluate( const uint64_t *pInputs, size_t count, uint8_t *pOutputs )
+{
+	const std::vector<char>& variables = m_pEquation->getUniqueVariables();
+	unsigned int variableCount = (unsigned int)variables.size();
+
+	// Transpose up to 64 inputs into lanes and simulate them together
+	for( size_t start = 0; start < count; start += 64 )
+	{
+		size_t lanes = (count - start < 64 ? count - start : 64);
+
+		for( unsigned int i = 0; i < variableCount; i++ )
+		{
+			unsigned int bit = variableCount - 1 - i;
+			uint64_t word = 0;
+			for( size_t lane = 0; lane < lanes; lane++ )
+				word |= ((pInputs[start + lane] >> bit) & 1) << lane;
+			m_slots[variables[i] - 'A'] = word;
+		}
+
+		uint64_t result = this->evaluateWord( m_slots );
+		for( size_t lane = 0; lane < lanes; lane++ )
+			pOutputs[start + lane] = (uint8_t)((result >> lane) & 1);
+	}
+}
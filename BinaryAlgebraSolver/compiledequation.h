@@ -0,0 +1,56 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "expressiongraph.h"
+#include "truthtable.h"
+
+// A parsed equation lowered to its expression graph. It is never changed
+// after compile(), so one instance can be shared by any number of threads,
+// each evaluating through its own CEvaluationContext.
+//
+// Inputs are packed the same way as truth table rows: with n variables the
+// low n bits are used and the first (alphabetical) variable is the most
+// significant of them.
+class CCompiledEquation
+{
+private:
+	CExpressionGraph m_graph;
+	std::string m_equation;
+	bool m_compiled;
+public:
+	CCompiledEquation();
+	~CCompiledEquation();
+
+	bool compile( const std::string& equation, int *pError );
+
+	// Convenience for one-off calls, keep a context around for repeated ones
+	bool evaluate( uint64_t input ) const;
+	void evaluate( const uint64_t *pInputs, size_t count, uint8_t *pOutputs ) const;
+
+	inline bool isCompiled() const { return m_compiled; }
+	inline const CExpressionGraph& getGraph() const { return m_graph; }
+	inline int getOutput() const { return m_graph.getOutput( 0 ); }
+	inline const std::string& getEquation() const { return m_equation; }
+	inline const std::vector<char>& getUniqueVariables() const { return m_graph.getUniqueVariables(); }
+	inline int getUniqueVariableCount() const { return m_graph.getUniqueVariableCount(); }
+};
+
+// Scratch space for evaluating a compiled equation. Cheap to make, but not
+// to be shared between threads.
+class CEvaluationContext
+{
+private:
+	const CCompiledEquation *m_pEquation;
+	std::vector<uint64_t> m_values;
+	uint64_t m_slots[INPUT_SLOT_COUNT];
+public:
+	CEvaluationContext( const CCompiledEquation& equation );
+	~CEvaluationContext();
+
+	bool evaluate( uint64_t input );
+	void evaluate( const uint64_t *pInputs, size_t count, uint8_t *pOutputs );
+	// 64 inputs at once, pSlots holds one lane word per letter
+	uint64_t evaluateWord( const uint64_t *pSlots );
+};
@@ -1,6 +1,8 @@
 #include <algorithm>
 #include <ctype.h>
+#include <string.h>
 #include "equationparser.h"
+#include "stats.h"
 
 unsigned char CEquationParser::getLiteralType( char ch )
 {
@@ -60,6 +62,7 @@ CEquationParser::~CEquationParser() {
 bool CEquationParser::parse( std::string eq, int *pError )
 {
 	unsigned char literalType;
+	STATS_TIMER( STATS_PHASE_PARSE );
 
 	if( pError )
 		*pError = PARSE_ERROR_OK;
@@ -73,6 +76,12 @@ bool CEquationParser::parse( std::string eq, int *pError )
 	// Clean up the input
 	// Remove all spaces
 	eq.erase( std::remove_if( eq.begin(), eq.end(), isspace ), eq.end() );
+	// Nothing but spaces is as good as nothing
+	if( eq.length() == 0 ) {
+		if( pError )
+			*pError = PARSE_ERROR_LENGTH;
+		return false;
+	}
 	// Make it all uppercase
 	std::transform( eq.begin(), eq.end(), eq.begin(), ::toupper );
 	// Check each character and make sure its valid
@@ -96,6 +105,7 @@ bool CEquationParser::parse( std::string eq, int *pError )
 			literalType = CEquationParser::getLiteralType( eq[i+1] );
 			if( literalType == LITERAL_TYPE_ALPHA || literalType == LITERAL_TYPE_NUMERIC || literalType == LITERAL_TYPE_PAREN ) {
 				eq.insert( i+1, 1, '*' );
+				STATS_INCREMENT( STAT_IMPLICIT_ANDS );
 				i++;
 			}
 			if( literalType == LITERAL_TYPE_NOT ) {
@@ -104,6 +114,7 @@ bool CEquationParser::parse( std::string eq, int *pError )
 					literalType = CEquationParser::getLiteralType( eq[i + 2] );
 					if( literalType == LITERAL_TYPE_ALPHA || literalType == LITERAL_TYPE_NUMERIC || literalType == LITERAL_TYPE_PAREN ) {
 						eq.insert( i + 2, 1, '*' );
+						STATS_INCREMENT( STAT_IMPLICIT_ANDS );
 						i += 2;
 					}
 				}
@@ -212,76 +223,80 @@ bool CEquationParser::parse( std::string eq, int *pError )
 
 	m_cleanEq = eq;
 
+	STATS_INCREMENT( STAT_EQUATIONS_PARSED );
+	STATS_ADD( STAT_TOKENS, m_tokens.size() );
 	return true;
 }
 
-EquationToken CEquationParser::evalPeek() {
-	return (*m_evaluationIterator);
+EquationToken CEquationParser::evalPeek( EvaluationState& state ) const {
+	return (*state.iterator);
 }
-EquationToken CEquationParser::evalGet() {
-	//printf( "Advancing from %c to", (*m_evaluationIterator).token );
-	//printf( " %c\n", (*(m_evaluationIterator+1)).token );
-	return (*m_evaluationIterator++);
+EquationToken CEquationParser::evalGet( EvaluationState& state ) const {
+	return (*state.iterator++);
 }
 
-bool CEquationParser::evalLiteral()
+bool CEquationParser::evalLiteral( EvaluationState& state ) const
 {
-	if( this->evalPeek().negated )
-		return !(m_variables[this->evalGet().token]);
-	return (m_variables[this->evalGet().token]);
+	state.variableLookups++;
+	if( this->evalPeek( state ).negated )
+		return !(state.variables[this->evalGet( state ).token & 0x7F]);
+	return (state.variables[this->evalGet( state ).token & 0x7F]);
 }
-bool CEquationParser::evalFactor()
+bool CEquationParser::evalFactor( EvaluationState& state ) const
 {
-	if( this->evalPeek().tokenType == TOKEN_TYPE_LITERAL )
-		return this->evalLiteral();
-	else if( this->evalPeek().tokenType == TOKEN_TYPE_LEFT_PAREN ) {
-		this->evalGet();
-		bool result = this->evalExpression();
-		this->evalGet(); // Syntax error possible here!
-		if( this->evalPeek().tokenType == TOKEN_TYPE_TERMNOT ) {
-			this->evalGet();
+	state.nodesVisited++;
+	if( this->evalPeek( state ).tokenType == TOKEN_TYPE_LITERAL )
+		return this->evalLiteral( state );
+	else if( this->evalPeek( state ).tokenType == TOKEN_TYPE_LEFT_PAREN ) {
+		this->evalGet( state );
+		bool result = this->evalExpression( state );
+		this->evalGet( state ); // Syntax error possible here!
+		if( this->evalPeek( state ).tokenType == TOKEN_TYPE_TERMNOT ) {
+			this->evalGet( state );
 			result = !result;
 		}
 		return result;
 	}
 	return true;
 }
-bool CEquationParser::evalTerm()
+bool CEquationParser::evalTerm( EvaluationState& state ) const
 {
-	bool result = this->evalFactor();
-	if( this->evalPeek().tokenType == TOKEN_TYPE_END )
+	bool result = this->evalFactor( state );
+	if( this->evalPeek( state ).tokenType == TOKEN_TYPE_END )
 		return result;
-	while( this->evalPeek().tokenType == TOKEN_TYPE_AND ) {
-		if( this->evalGet().tokenType == TOKEN_TYPE_AND ) {
-			bool partOfBool = this->evalFactor();
+	while( this->evalPeek( state ).tokenType == TOKEN_TYPE_AND ) {
+		if( this->evalGet( state ).tokenType == TOKEN_TYPE_AND ) {
+			bool partOfBool = this->evalFactor( state );
 			result = (result && partOfBool);
 		}
 	}
 	return result;
 }
-bool CEquationParser::evalExpression()
+bool CEquationParser::evalExpression( EvaluationState& state ) const
 {
-	bool result = this->evalTerm();
-	if( this->evalPeek().tokenType == TOKEN_TYPE_END )
+	bool result = this->evalTerm( state );
+	if( this->evalPeek( state ).tokenType == TOKEN_TYPE_END )
 		return result;
-	while( this->evalPeek().tokenType == TOKEN_TYPE_OR || this->evalPeek().tokenType == TOKEN_TYPE_XOR )
+	while( this->evalPeek( state ).tokenType == TOKEN_TYPE_OR || this->evalPeek( state ).tokenType == TOKEN_TYPE_XOR )
 	{
-		if( this->evalPeek().tokenType == TOKEN_TYPE_OR ) {
-			this->evalGet();
-			bool partOfBool = this->evalTerm();
+		if( this->evalPeek( state ).tokenType == TOKEN_TYPE_OR ) {
+			this->evalGet( state );
+			bool partOfBool = this->evalTerm( state );
 			result = (result || partOfBool);
 		}
-		else if( this->evalPeek().tokenType == TOKEN_TYPE_XOR ) {
-			this->evalGet();
-			bool partOfBool = this->evalTerm();
+		else if( this->evalPeek( state ).tokenType == TOKEN_TYPE_XOR ) {
+			this->evalGet( state );
+			bool partOfBool = this->evalTerm( state );
 			result = result ^ partOfBool;
 		}
 	}
 	return result;
 }
 
-bool CEquationParser::evaluate( std::string input, bool *pResult, int *pError )
+bool CEquationParser::evaluate( std::string input, bool *pResult, int *pError ) const
 {
+	EvaluationState state;
+	STATS_TIMER( STATS_PHASE_EVALUATE );
 	if( pError )
 		*pError = PARSE_ERROR_OK;
 
@@ -291,16 +306,21 @@ bool CEquationParser::evaluate( std::string input, bool *pResult, int *pError )
 			*pError = PARSE_ERROR_INPUT;
 		return false;
 	}
-	m_variables.clear();
+	memset( state.variables, 0, sizeof( state.variables ) );
 	for( unsigned int i = 0; i < m_uniqueVariables.size(); i++ )
-		m_variables.insert( std::pair<char, bool>( m_uniqueVariables[i], (input[i] == '0' ? false : true) ) );
-	m_variables.insert( std::pair<char, bool>( '0', false ) );
-	m_variables.insert( std::pair<char, bool>( '1', true ) );
+		state.variables[m_uniqueVariables[i] & 0x7F] = (input[i] == '0' ? false : true);
+	state.variables['0'] = false;
+	state.variables['1'] = true;
+	state.nodesVisited = 0;
+	state.variableLookups = 0;
 
 	// Begin recursive descent
-	m_evaluationIterator = m_tokens.begin();
-	bool result = this->evalExpression();
+	state.iterator = m_tokens.begin();
+	bool result = this->evalExpression( state );
 	*pResult = result;
 
+	STATS_INCREMENT( STAT_ROWS_EVALUATED );
+	STATS_ADD( STAT_NODES_VISITED, state.nodesVisited );
+	STATS_ADD( STAT_VARIABLE_LOOKUPS, state.variableLookups );
 	return true;
 }
\ No newline at end of file
@@ -1,7 +1,7 @@
 #pragma once
+#include <math.h>
 #include <string>
 #include <vector>
-#include <map>
 
 enum
 {
@@ -46,6 +46,17 @@ struct EquationToken
 	}
 };
 
+// Everything one evaluation touches, kept off the parser so a parsed
+// equation can be evaluated from several threads at once
+struct EvaluationState
+{
+	bool variables[128];
+	std::vector<EquationToken>::const_iterator iterator;
+	// Counted here and handed to the stats once per evaluate()
+	unsigned int nodesVisited;
+	unsigned int variableLookups;
+};
+
 class CEquationParser
 {
 private:
@@ -53,16 +64,13 @@ private:
 	std::vector<EquationToken> m_tokens;
 	std::vector<char> m_uniqueVariables;
 
-	std::map<char, bool> m_variables;
-	std::vector<EquationToken>::iterator m_evaluationIterator;
-
-	EquationToken evalPeek();
-	EquationToken evalGet();
+	EquationToken evalPeek( EvaluationState& state ) const;
+	EquationToken evalGet( EvaluationState& state ) const;
 
-	bool evalLiteral();
-	bool evalFactor();
-	bool evalTerm();
-	bool evalExpression();
+	bool evalLiteral( EvaluationState& state ) const;
+	bool evalFactor( EvaluationState& state ) const;
+	bool evalTerm( EvaluationState& state ) const;
+	bool evalExpression( EvaluationState& state ) const;
 public:
 	static unsigned char getLiteralType( char ch );
 	static bool sanitizeInput( std::string inputStr );
@@ -71,10 +79,11 @@ public:
 	~CEquationParser();
 
 	bool parse( std::string eq, int *pError );
-	bool evaluate( std::string input, bool *pResult, int *pError );
+	bool evaluate( std::string input, bool *pResult, int *pError ) const;
 
-	inline const std::string& getCleanEquation() { return m_cleanEq; }
-	inline const std::vector<char>& getUniqueVariables() { return m_uniqueVariables; }
-	inline int getUniqueVariableCount() { return m_uniqueVariables.size(); }
-	inline int getMaxInputs() { return (int)pow( 2, m_uniqueVariables.size() ); }
+	inline const std::string& getCleanEquation() const { return m_cleanEq; }
+	inline const std::vector<EquationToken>& getTokens() const { return m_tokens; }
+	inline const std::vector<char>& getUniqueVariables() const { return m_uniqueVariables; }
+	inline int getUniqueVariableCount() const { return m_uniqueVariables.size(); }
+	inline int getMaxInputs() const { return (int)pow( 2, m_uniqueVariables.size() ); }
 };
@@ -0,0 +1,156 @@
+#include "equivalence.h"
+#include <algorithm>
+#include <functional>
+#include <vector>
+#include "stats.h"
+#include "util.h"
+
+// Words of 64 random inputs simulated before falling back to enumeration
+#define EQUIVALENCE_RANDOM_WORDS 64
+// Enumerated words between progress checks
+#define EQUIVALENCE_PROGRESS_WORDS 1024
+
+// Rebuilds the row index a lane was simulated with
+static uint64_t GetLaneRow( const std::vector<char>& uniqueVariables, const uint64_t *pSlots, int lane )
+{
+	uint64_t row = 0;
+	for( unsigned int i = 0; i < uniqueVariables.size(); i++ )
+		row = (row << 1) | ((pSlots[uniqueVariables[i] - 'A'] >> lane) & 1);
+	return row;
+}
+
+// Simulates one word of inputs, returns the lanes where the outputs differ
+typedef std::function<uint64_t( const uint64_t *pSlots )> DifferenceFunction;
+
+// Staged search for an input where the difference is set
+static void FindDifference( const std::vector<char>& variables, const DifferenceFunction& simulateDifference, EquivalenceResult *pResult, CProgress *pProgress )
+{
+	uint64_t slots[INPUT_SLOT_COUNT] = { 0 };
+	uint64_t difference;
+	unsigned int variableCount = (unsigned int)variables.size();
+	STATS_TIMER( STATS_PHASE_COMPARE );
+
+	pResult->equal = false;
+	pResult->counterexample = 0;
+	pResult->rowsChecked = 0;
+	pResult->complete = true;
+	pResult->exhaustiveRows = 0;
+
+	// Up to 6 variables one exhaustive word is cheaper than simulating
+	if( variableCount > 6 )
+	{
+		// Corner cases, lane 0 is all zeros, 1 is all ones, then one-hot
+		// and one-cold for each variable
+		unsigned int laneCount = 2 + 2 * variableCount;
+		for( unsigned int i = 0; i < variableCount; i++ ) {
+			slots[variables[i] - 'A'] = ((uint64_t)1 << 1) | ((uint64_t)1 << (2 + i));
+			slots[variables[i] - 'A'] |= (((uint64_t)1 << variableCount) - 1) << (2 + variableCount) & ~((uint64_t)1 << (2 + variableCount + i));
+		}
+		difference = simulateDifference( slots ) & ((laneCount >= 64) ? ~(uint64_t)0 : (((uint64_t)1 << laneCount) - 1));
+		pResult->rowsChecked += laneCount;
+		if( difference != 0 ) {
+			pResult->stage = EQUIVALENCE_STAGE_CORNER;
+			pResult->counterexample = GetLaneRow( variables, slots, CountTrailingZeros( difference ) );
+			return;
+		}
+
+		// Random inputs from a fixed seed so runs are repeatable
+		uint64_t state = 0x9E3779B97F4A7C15ULL;
+		for( int word = 0; word < EQUIVALENCE_RANDOM_WORDS; word++ )
+		{
+			for( unsigned int i = 0; i < variableCount; i++ ) {
+				state ^= state << 13;
+				state ^= state >> 7;
+				state ^= state << 17;
+				slots[variables[i] - 'A'] = state;
+			}
+			difference = simulateDifference( slots );
+			pResult->rowsChecked += 64;
+			if( difference != 0 ) {
+				pResult->stage = EQUIVALENCE_STAGE_RANDOM;
+				pResult->counterexample = GetLaneRow( variables, slots, CountTrailingZeros( difference ) );
+				return;
+			}
+		}
+	}
+
+	// Enumerate in row order, stopping at the first mismatch
+	uint64_t wordCount = CTruthTable::getWordCount( variableCount );
+	uint64_t mask = CTruthTable::getLastWordMask( variableCount );
+	pResult->stage = EQUIVALENCE_STAGE_EXHAUSTIVE;
+	for( uint64_t i = 0; i < wordCount; i++ )
+	{
+		if( pProgress && i % EQUIVALENCE_PROGRESS_WORDS == 0 && i != 0 && !pProgress->addRows( EQUIVALENCE_PROGRESS_WORDS * 64 ) ) {
+			pResult->complete = false;
+			return;
+		}
+		CTruthTable::fillInputSlots( variables, i, slots );
+		difference = simulateDifference( slots ) & mask;
+		if( difference != 0 ) {
+			pResult->counterexample = (i << 6) + CountTrailingZeros( difference );
+			pResult->rowsChecked += pResult->counterexample - (i << 6) + 1;
+			return;
+		}
+		pResult->rowsChecked += (variableCount < 6 ? (uint64_t)1 << variableCount : 64);
+		pResult->exhaustiveRows += (variableCount < 6 ? (uint64_t)1 << variableCount : 64);
+	}
+	pResult->equal = true;
+}
+
+void CheckEquivalence( const CExpressionGraph& graph, int outputA, int outputB, EquivalenceResult *pResult, CProgress *pProgress ) {
+	CheckEquivalence( graph, outputA, graph, outputB, pResult, pProgress );
+}
+
+void CheckEquivalence( const CExpressionGraph& graphA, int outputA, const CExpressionGraph& graphB, int outputB, EquivalenceResult *pResult, CProgress *pProgress )
+{
+	std::vector<char> variables = graphA.getUniqueVariables();
+	std::vector<uint64_t> valuesA( graphA.getNodeCount() ), valuesB( graphB.getNodeCount() );
+
+	// Identical nodes are trivially the same function
+	if( &graphA == &graphB && graphA.getOutput( outputA ) == graphB.getOutput( outputB ) ) {
+		pResult->equal = true;
+		pResult->stage = EQUIVALENCE_STAGE_CORNER;
+		pResult->counterexample = 0;
+		pResult->rowsChecked = 0;
+		pResult->complete = true;
+		pResult->exhaustiveRows = 0;
+		return;
+	}
+
+	// Search the inputs of both
+	const std::vector<char>& variablesB = graphB.getUniqueVariables();
+	for( auto it = variablesB.begin(); it != variablesB.end(); it++ ) {
+		if( std::find( variables.begin(), variables.end(), (*it) ) == variables.end() )
+			variables.push_back( (*it) );
+	}
+	std::sort( variables.begin(), variables.end() );
+
+	FindDifference( variables, [&]( const uint64_t *pSlots )->uint64_t {
+		graphA.evaluateWord( pSlots, &valuesA[0] );
+		if( &graphA == &graphB )
+			return valuesA[graphA.getOutput( outputA )] ^ valuesA[graphB.getOutput( outputB )];
+		graphB.evaluateWord( pSlots, &valuesB[0] );
+		return valuesA[graphA.getOutput( outputA )] ^ valuesB[graphB.getOutput( outputB )];
+	}, pResult, pProgress );
+}
+
+void CheckEquivalence( const CAig& aig, int outputA, int outputB, EquivalenceResult *pResult, CProgress *pProgress )
+{
+	std::vector<uint64_t> values( aig.getNodeCount() );
+
+	// Structural hashing already merged anything obviously the same
+	if( aig.getOutput( outputA ) == aig.getOutput( outputB ) ) {
+		pResult->equal = true;
+		pResult->stage = EQUIVALENCE_STAGE_CORNER;
+		pResult->counterexample = 0;
+		pResult->rowsChecked = 0;
+		pResult->complete = true;
+		pResult->exhaustiveRows = 0;
+		return;
+	}
+
+	FindDifference( aig.getUniqueVariables(), [&]( const uint64_t *pSlots )->uint64_t {
+		aig.simulateWord( pSlots, &values[0] );
+		return aig.getOutputWord( &values[0], outputA ) ^ aig.getOutputWord( &values[0], outputB );
+	}, pResult, pProgress );
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include <stdint.h>
+#include "aig.h"
+#include "expressiongraph.h"
+#include "progress.h"
+
+enum
+{
+	EQUIVALENCE_STAGE_CORNER,
+	EQUIVALENCE_STAGE_RANDOM,
+	EQUIVALENCE_STAGE_EXHAUSTIVE
+};
+
+struct EquivalenceResult
+{
+	bool equal;
+	int stage;
+	uint64_t counterexample;
+	uint64_t rowsChecked;
+	// False when the progress limits stopped the search before it could
+	// decide, rows 0 to exhaustiveRows - 1 were all checked and agree
+	bool complete;
+	uint64_t exhaustiveRows;
+};
+
+// Decides whether two outputs of a graph are the same function, stopping at
+// the first distinguishing input. Corner cases (all zeros, all ones, one-hot
+// and one-cold) and a fixed batch of random inputs are simulated before the
+// exhaustive search, which is what usually finds non-equivalent pairs.
+// Outputs of different graphs are compared over the union of their inputs.
+void CheckEquivalence( const CExpressionGraph& graph, int outputA, int outputB, EquivalenceResult *pResult, CProgress *pProgress = 0 );
+void CheckEquivalence( const CExpressionGraph& graphA, int outputA, const CExpressionGraph& graphB, int outputB, EquivalenceResult *pResult, CProgress *pProgress = 0 );
+// Two outputs of the same AIG, copy one in with CAig::addAig() to compare
+// outputs of different ones
+void CheckEquivalence( const CAig& aig, int outputA, int outputB, EquivalenceResult *pResult, CProgress *pProgress = 0 );
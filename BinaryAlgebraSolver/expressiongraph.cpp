@@ -0,0 +1,420 @@
+#include "expressiongraph.h"
+#include <string.h>
+#include <algorithm>
+#include "stats.h"
+
+CExpressionGraph::CExpressionGraph()
+{
+	m_pBuildTokens = 0;
+	m_buildPosition = 0;
+
+	// Node 0 and 1 are always the constants
+	this->addNode( NODE_TYPE_CONST0, 0, -1, -1 );
+	this->addNode( NODE_TYPE_CONST1, 0, -1, -1 );
+}
+CExpressionGraph::~CExpressionGraph() {
+}
+
+int CExpressionGraph::addNode( unsigned char nodeType, char variable, int left, int right )
+{
+	// Reuse the node if it already exists
+	auto key = std::make_tuple( nodeType, variable, left, right );
+	auto it = m_nodeLookup.find( key );
+	if( it != m_nodeLookup.end() )
+		return (*it).second;
+
+	ExpressionNode node;
+	node.nodeType = nodeType;
+	node.variable = variable;
+	node.left = left;
+	node.right = right;
+	m_nodes.push_back( node );
+	m_nodeLookup.insert( std::make_pair( key, (int)m_nodes.size() - 1 ) );
+
+	return (int)m_nodes.size() - 1;
+}
+
+int CExpressionGraph::makeConstant( bool value ) {
+	return (value ? 1 : 0);
+}
+int CExpressionGraph::makeVariable( char variable ) {
+	return this->addNode( NODE_TYPE_VARIABLE, variable, -1, -1 );
+}
+int CExpressionGraph::makeNot( int node )
+{
+	if( node == 0 )
+		return 1;
+	if( node == 1 )
+		return 0;
+	// Double negation
+	if( m_nodes[node].nodeType == NODE_TYPE_NOT )
+		return m_nodes[node].left;
+	return this->addNode( NODE_TYPE_NOT, 0, node, -1 );
+}
+int CExpressionGraph::makeAnd( int left, int right )
+{
+	if( left == 0 || right == 0 )
+		return 0;
+	if( left == 1 )
+		return right;
+	if( right == 1 || left == right )
+		return left;
+	if( (m_nodes[left].nodeType == NODE_TYPE_NOT && m_nodes[left].left == right) ||
+		(m_nodes[right].nodeType == NODE_TYPE_NOT && m_nodes[right].left == left) )
+		return 0;
+	// Commutative, so keep the operands ordered for hashing
+	if( left > right )
+		std::swap( left, right );
+	return this->addNode( NODE_TYPE_AND, 0, left, right );
+}
+int CExpressionGraph::makeOr( int left, int right )
+{
+	if( left == 1 || right == 1 )
+		return 1;
+	if( left == 0 )
+		return right;
+	if( right == 0 || left == right )
+		return left;
+	if( (m_nodes[left].nodeType == NODE_TYPE_NOT && m_nodes[left].left == right) ||
+		(m_nodes[right].nodeType == NODE_TYPE_NOT && m_nodes[right].left == left) )
+		return 1;
+	if( left > right )
+		std::swap( left, right );
+	return this->addNode( NODE_TYPE_OR, 0, left, right );
+}
+int CExpressionGraph::makeXor( int left, int right )
+{
+	if( left == 0 )
+		return right;
+	if( right == 0 )
+		return left;
+	if( left == 1 )
+		return this->makeNot( right );
+	if( right == 1 )
+		return this->makeNot( left );
+	if( left == right )
+		return 0;
+	if( left > right )
+		std::swap( left, right );
+	return this->addNode( NODE_TYPE_XOR, 0, left, right );
+}
+
+// Lowering mirrors the recursive descent in CEquationParser::evaluate, so the
+// graph gives exactly the same results as the token interpreter
+EquationToken CExpressionGraph::buildPeek()
+{
+	if( m_buildPosition >= m_pBuildTokens->size() ) {
+		EquationToken endToken;
+		endToken.tokenType = TOKEN_TYPE_END;
+		endToken.token = ' ';
+		endToken.negated = false;
+		return endToken;
+	}
+	return (*m_pBuildTokens)[m_buildPosition];
+}
+EquationToken CExpressionGraph::buildGet()
+{
+	EquationToken token = this->buildPeek();
+	m_buildPosition++;
+	return token;
+}
+
+int CExpressionGraph::buildLiteral()
+{
+	EquationToken token = this->buildGet();
+	int node;
+
+	if( token.token == '0' || token.token == '1' )
+		node = this->makeConstant( token.token == '1' );
+	else
+		node = this->makeVariable( token.token );
+	if( token.negated )
+		node = this->makeNot( node );
+	return node;
+}
+int CExpressionGraph::buildFactor()
+{
+	if( this->buildPeek().tokenType == TOKEN_TYPE_LITERAL )
+		return this->buildLiteral();
+	else if( this->buildPeek().tokenType == TOKEN_TYPE_LEFT_PAREN ) {
+		this->buildGet();
+		int node = this->buildExpression();
+		this->buildGet();
+		if( this->buildPeek().tokenType == TOKEN_TYPE_TERMNOT ) {
+			this->buildGet();
+			node = this->makeNot( node );
+		}
+		return node;
+	}
+	return this->makeConstant( true );
+}
+int CExpressionGraph::buildTerm()
+{
+	int node = this->buildFactor();
+	while( this->buildPeek().tokenType == TOKEN_TYPE_AND ) {
+		this->buildGet();
+		node = this->makeAnd( node, this->buildFactor() );
+	}
+	return node;
+}
+int CExpressionGraph::buildExpression()
+{
+	int node = this->buildTerm();
+	while( this->buildPeek().tokenType == TOKEN_TYPE_OR || this->buildPeek().tokenType == TOKEN_TYPE_XOR )
+	{
+		if( this->buildGet().tokenType == TOKEN_TYPE_OR )
+			node = this->makeOr( node, this->buildTerm() );
+		else
+			node = this->makeXor( node, this->buildTerm() );
+	}
+	return node;
+}
+
+bool CExpressionGraph::addEquation( CEquationParser& parser, int *pError )
+{
+	if( pError )
+		*pError = PARSE_ERROR_OK;
+
+	// The parser has to have run first
+	if( parser.getTokens().size() == 0 ) {
+		if( pError )
+			*pError = PARSE_ERROR_LENGTH;
+		return false;
+	}
+
+	m_pBuildTokens = &parser.getTokens();
+	m_buildPosition = 0;
+	int root = this->buildExpression();
+	m_pBuildTokens = 0;
+
+	this->addOutput( root, parser.getCleanEquation() );
+
+	// Inputs are shared between all of the outputs
+	const std::vector<char>& variables = parser.getUniqueVariables();
+	for( auto it = variables.begin(); it != variables.end(); it++ ) {
+		if( std::find( m_uniqueVariables.begin(), m_uniqueVariables.end(), (*it) ) == m_uniqueVariables.end() )
+			m_uniqueVariables.push_back( (*it) );
+	}
+	std::sort( m_uniqueVariables.begin(), m_uniqueVariables.end() );
+
+	return true;
+}
+int CExpressionGraph::addOutput( int node, std::string equation )
+{
+	m_outputs.push_back( node );
+	m_outputEquations.push_back( equation );
+	return (int)m_outputs.size() - 1;
+}
+
+void CExpressionGraph::addCofactor( const CExpressionGraph& source, char variable, bool value )
+{
+	std::vector<int> nodeMap( source.m_nodes.size(), 0 );
+	std::vector<bool> reachable( source.m_nodes.size(), false );
+
+	// Only what the outputs use, marked from the top down
+	for( unsigned int i = 0; i < source.m_outputs.size(); i++ )
+		reachable[source.m_outputs[i]] = true;
+	for( int i = (int)source.m_nodes.size() - 1; i >= 0; i-- ) {
+		if( !reachable[i] )
+			continue;
+		if( source.m_nodes[i].left >= 0 )
+			reachable[source.m_nodes[i].left] = true;
+		if( source.m_nodes[i].right >= 0 )
+			reachable[source.m_nodes[i].right] = true;
+	}
+
+	for( unsigned int i = 0; i < source.m_nodes.size(); i++ )
+	{
+		const ExpressionNode& node = source.m_nodes[i];
+		if( !reachable[i] )
+			continue;
+		switch( node.nodeType )
+		{
+		case NODE_TYPE_CONST0:
+		case NODE_TYPE_CONST1:
+			nodeMap[i] = this->makeConstant( node.nodeType == NODE_TYPE_CONST1 );
+			break;
+		case NODE_TYPE_VARIABLE:
+			nodeMap[i] = (node.variable == variable ? this->makeConstant( value ) : this->makeVariable( node.variable ));
+			break;
+		case NODE_TYPE_NOT:
+			nodeMap[i] = this->makeNot( nodeMap[node.left] );
+			break;
+		case NODE_TYPE_AND:
+			nodeMap[i] = this->makeAnd( nodeMap[node.left], nodeMap[node.right] );
+			break;
+		case NODE_TYPE_OR:
+			nodeMap[i] = this->makeOr( nodeMap[node.left], nodeMap[node.right] );
+			break;
+		case NODE_TYPE_XOR:
+			nodeMap[i] = this->makeXor( nodeMap[node.left], nodeMap[node.right] );
+			break;
+		}
+	}
+
+	for( unsigned int i = 0; i < source.m_outputs.size(); i++ )
+		this->addOutput( nodeMap[source.m_outputs[i]], source.m_outputEquations[i] );
+	m_uniqueVariables = source.m_uniqueVariables;
+}
+
+void CExpressionGraph::evaluateWord( const uint64_t *pSlots, uint64_t *pValues ) const
+{
+	STATS_INCREMENT( STAT_WORDS_EVALUATED );
+	STATS_ADD( STAT_NODES_VISITED, m_nodes.size() );
+
+	// Nodes are always created after their operands, so one forward pass works
+	for( unsigned int i = 0; i < m_nodes.size(); i++ )
+	{
+		const ExpressionNode& node = m_nodes[i];
+		switch( node.nodeType )
+		{
+		case NODE_TYPE_CONST0:
+			pValues[i] = 0;
+			break;
+		case NODE_TYPE_CONST1:
+			pValues[i] = ~(uint64_t)0;
+			break;
+		case NODE_TYPE_VARIABLE:
+			pValues[i] = pSlots[node.variable - 'A'];
+			break;
+		case NODE_TYPE_NOT:
+			pValues[i] = ~pValues[node.left];
+			break;
+		case NODE_TYPE_AND:
+			pValues[i] = pValues[node.left] & pValues[node.right];
+			break;
+		case NODE_TYPE_OR:
+			pValues[i] = pValues[node.left] | pValues[node.right];
+			break;
+		case NODE_TYPE_XOR:
+			pValues[i] = pValues[node.left] ^ pValues[node.right];
+			break;
+		}
+	}
+}
+
+void CExpressionGraph::evaluateRange( std::vector<CTruthTable> *pTables, uint64_t startWord, uint64_t endWord ) const
+{
+	std::vector<uint64_t> values( m_nodes.size() );
+	uint64_t slots[INPUT_SLOT_COUNT] = { 0 };
+
+	// Every output is produced from the same pass over the nodes
+	for( uint64_t i = startWord; i < endWord; i++ )
+	{
+		CTruthTable::fillInputSlots( m_uniqueVariables, i, slots );
+		this->evaluateWord( slots, &values[0] );
+		for( unsigned int j = 0; j < m_outputs.size(); j++ )
+			(*pTables)[j].setWord( i, values[m_outputs[j]] );
+	}
+}
+
+void CExpressionGraph::evaluateBlock( uint64_t startWord, uint64_t wordCount, uint64_t *pBlock ) const
+{
+	std::vector<uint64_t> values( m_nodes.size() );
+	uint64_t slots[INPUT_SLOT_COUNT] = { 0 };
+	uint64_t mask = ~(uint64_t)0;
+
+	// Tables under 64 rows only use the low bits of their only word
+	if( m_uniqueVariables.size() < 6 )
+		mask = ((uint64_t)1 << (1 << m_uniqueVariables.size())) - 1;
+	for( uint64_t i = 0; i < wordCount; i++ )
+	{
+		CTruthTable::fillInputSlots( m_uniqueVariables, startWord + i, slots );
+		this->evaluateWord( slots, &values[0] );
+		for( unsigned int j = 0; j < m_outputs.size(); j++ )
+			pBlock[j * wordCount + i] = values[m_outputs[j]] & mask;
+	}
+	STATS_ADD( STAT_ROWS_EVALUATED, wordCount << (m_uniqueVariables.size() < 6 ? m_uniqueVariables.size() : 6) );
+}
+
+void CExpressionGraph::evaluateTables( std::vector<CTruthTable> *pTables ) const
+{
+	STATS_TIMER( STATS_PHASE_EVALUATE );
+
+	pTables->assign( m_outputs.size(), CTruthTable( m_uniqueVariables ) );
+	this->evaluateRange( pTables, 0, CTruthTable::getWordCount( (unsigned int)m_uniqueVariables.size() ) );
+	STATS_ADD( STAT_ROWS_EVALUATED, (uint64_t)1 << m_uniqueVariables.size() );
+}
+
+void CExpressionGraph::evaluateTables( std::vector<CTruthTable> *pTables, CTaskScheduler& scheduler ) const
+{
+	uint64_t wordCount = CTruthTable::getWordCount( (unsigned int)m_uniqueVariables.size() );
+	if( wordCount <= EVALUATE_SPLIT_WORDS ) {
+		this->evaluateTables( pTables );
+		return;
+	}
+	STATS_TIMER( STATS_PHASE_EVALUATE );
+
+	// Ranges cover whole words, so no two tasks write the same one
+	pTables->assign( m_outputs.size(), CTruthTable( m_uniqueVariables ) );
+	CTaskGroup group;
+	for( uint64_t start = 0; start < wordCount; start += EVALUATE_SPLIT_WORDS )
+	{
+		uint64_t end = std::min( start + EVALUATE_SPLIT_WORDS, wordCount );
+		scheduler.submit( group, [this, pTables, start, end]() {
+			this->evaluateRange( pTables, start, end );
+		} );
+	}
+	scheduler.wait( group );
+	STATS_ADD( STAT_ROWS_EVALUATED, (uint64_t)1 << m_uniqueVariables.size() );
+}
+
+void CExpressionGraph::evaluateCofactorRange( std::vector<CTruthTable> *pTables, uint64_t startWord, uint64_t wordCount, unsigned int depth, CTaskScheduler& scheduler ) const
+{
+	bool allConstant = true;
+	for( unsigned int i = 0; i < m_outputs.size(); i++ ) {
+		if( m_outputs[i] > 1 )
+			allConstant = false;
+	}
+
+	// Nothing left to evaluate, the tables start out all zeros so only
+	// the ones need filling
+	if( allConstant )
+	{
+		for( unsigned int i = 0; i < m_outputs.size(); i++ ) {
+			if( m_outputs[i] == 1 )
+				memset( &(*pTables)[i].getWords()[(size_t)startWord], 0xFF, (size_t)wordCount * sizeof( uint64_t ) );
+		}
+		STATS_ADD( STAT_ROWS_PRUNED, wordCount << 6 );
+		return;
+	}
+	if( wordCount <= COFACTOR_LEAF_WORDS ) {
+		this->evaluateRange( pTables, startWord, startWord + wordCount );
+		STATS_ADD( STAT_ROWS_EVALUATED, wordCount << 6 );
+		return;
+	}
+
+	CExpressionGraph low, high;
+	uint64_t half = wordCount / 2;
+	low.addCofactor( *this, m_uniqueVariables[depth], false );
+	high.addCofactor( *this, m_uniqueVariables[depth], true );
+
+	// Big halves go to the pool, small ones aren't worth a task
+	if( wordCount > EVALUATE_SPLIT_WORDS )
+	{
+		CTaskGroup group;
+		const CExpressionGraph *pHigh = &high;
+		scheduler.submit( group, [pHigh, pTables, startWord, half, depth, &scheduler]() {
+			pHigh->evaluateCofactorRange( pTables, startWord + half, half, depth + 1, scheduler );
+		} );
+		low.evaluateCofactorRange( pTables, startWord, half, depth + 1, scheduler );
+		scheduler.wait( group );
+	}
+	else {
+		low.evaluateCofactorRange( pTables, startWord, half, depth + 1, scheduler );
+		high.evaluateCofactorRange( pTables, startWord + half, half, depth + 1, scheduler );
+	}
+}
+
+void CExpressionGraph::evaluateCofactors( std::vector<CTruthTable> *pTables, CTaskScheduler& scheduler ) const
+{
+	uint64_t wordCount = CTruthTable::getWordCount( (unsigned int)m_uniqueVariables.size() );
+	if( wordCount <= COFACTOR_LEAF_WORDS ) {
+		this->evaluateTables( pTables );
+		return;
+	}
+	STATS_TIMER( STATS_PHASE_EVALUATE );
+
+	pTables->assign( m_outputs.size(), CTruthTable( m_uniqueVariables ) );
+	this->evaluateCofactorRange( pTables, 0, wordCount, 0, scheduler );
+}
@@ -0,0 +1,99 @@
+#pragma once
+#include <stdint.h>
+#include <map>
+#include <string>
+#include <tuple>
+#include <vector>
+#include "equationparser.h"
+#include "scheduler.h"
+#include "truthtable.h"
+
+// Tables longer than this many words are evaluated in pieces of this size
+#define EVALUATE_SPLIT_WORDS 1024
+// Cofactoring stops once a range is down to this many words
+#define COFACTOR_LEAF_WORDS 64
+
+enum : unsigned char
+{
+	NODE_TYPE_CONST0,
+	NODE_TYPE_CONST1,
+	NODE_TYPE_VARIABLE,
+	NODE_TYPE_NOT,
+	NODE_TYPE_AND,
+	NODE_TYPE_OR,
+	NODE_TYPE_XOR
+};
+
+struct ExpressionNode
+{
+	unsigned char nodeType;
+	char variable;
+	int left;
+	int right;
+};
+
+// A structurally hashed expression DAG that any number of parsed equations
+// are lowered into. Identical subterms are only stored once, so a bank of
+// outputs over the same inputs is evaluated with shared work.
+class CExpressionGraph
+{
+private:
+	std::vector<ExpressionNode> m_nodes;
+	std::map<std::tuple<unsigned char, char, int, int>, int> m_nodeLookup;
+	std::vector<int> m_outputs;
+	std::vector<std::string> m_outputEquations;
+	std::vector<char> m_uniqueVariables;
+
+	const std::vector<EquationToken> *m_pBuildTokens;
+	unsigned int m_buildPosition;
+
+	int addNode( unsigned char nodeType, char variable, int left, int right );
+
+	EquationToken buildPeek();
+	EquationToken buildGet();
+
+	int buildLiteral();
+	int buildFactor();
+	int buildTerm();
+	int buildExpression();
+
+	void evaluateRange( std::vector<CTruthTable> *pTables, uint64_t startWord, uint64_t endWord ) const;
+	void evaluateCofactorRange( std::vector<CTruthTable> *pTables, uint64_t startWord, uint64_t wordCount, unsigned int depth, CTaskScheduler& scheduler ) const;
+public:
+	CExpressionGraph();
+	~CExpressionGraph();
+
+	int makeConstant( bool value );
+	int makeVariable( char variable );
+	int makeNot( int node );
+	int makeAnd( int left, int right );
+	int makeOr( int left, int right );
+	int makeXor( int left, int right );
+
+	bool addEquation( CEquationParser& parser, int *pError );
+	int addOutput( int node, std::string equation );
+	// Copies every output of the source in with the variable fixed to a
+	// constant, the folding in the make functions simplifies what is left.
+	// The inputs stay the same, so rows line up with the source's.
+	void addCofactor( const CExpressionGraph& source, char variable, bool value );
+
+	void evaluateWord( const uint64_t *pSlots, uint64_t *pValues ) const;
+	// Output i of the words goes to pBlock + i * wordCount
+	void evaluateBlock( uint64_t startWord, uint64_t wordCount, uint64_t *pBlock ) const;
+	void evaluateTables( std::vector<CTruthTable> *pTables ) const;
+	// Large tables are split into word ranges the workers share
+	void evaluateTables( std::vector<CTruthTable> *pTables, CTaskScheduler& scheduler ) const;
+	// Splits on the first variables, which are the high row bits, so each
+	// cofactor is a contiguous half of its range. Halves are evaluated in
+	// parallel and a range whose outputs all fold to constants is filled
+	// without evaluating it.
+	void evaluateCofactors( std::vector<CTruthTable> *pTables, CTaskScheduler& scheduler ) const;
+
+	inline const ExpressionNode& getNode( int node ) const { return m_nodes[node]; }
+	inline int getNodeCount() const { return (int)m_nodes.size(); }
+	inline int getOutput( int output ) const { return m_outputs[output]; }
+	inline int getOutputCount() const { return (int)m_outputs.size(); }
+	inline const std::string& getOutputEquation( int output ) const { return m_outputEquations[output]; }
+	inline const std::vector<char>& getUniqueVariables() const { return m_uniqueVariables; }
+	inline int getUniqueVariableCount() const { return (int)m_uniqueVariables.size(); }
+};
@@ -0,0 +1,167 @@
+#include "grader.h"
+#include <algorithm>
+#include "equationparser.h"
+#include "expressiongraph.h"
+#include "util.h"
+
+// Candidates are handed out in small batches so stealing stays cheap
+#define GRADE_BATCH_SIZE 16
+// References longer than this many words split each candidate up
+#define GRADE_SPLIT_WORDS 1024
+
+CGrader::CGrader() {
+}
+CGrader::~CGrader() {
+}
+
+bool CGrader::setReference( std::string equation, int *pError )
+{
+	CEquationParser parser;
+	CExpressionGraph graph;
+	std::vector<CTruthTable> tables;
+
+	if( !parser.parse( equation, pError ) )
+		return false;
+	if( !graph.addEquation( parser, pError ) )
+		return false;
+	graph.evaluateTables( &tables );
+
+	m_referenceTable = tables[0];
+	m_referenceEquation = parser.getCleanEquation();
+
+	return true;
+}
+
+// Mismatches over a range of words, firstMismatch is only set if one was
+// found. Returns false without checking anything once the run is stopped.
+bool CGrader::gradeRange( const CExpressionGraph& graph, uint64_t startWord, uint64_t endWord, GradeResult *pResult, CProgress *pProgress ) const
+{
+	const std::vector<char>& referenceVariables = m_referenceTable.getUniqueVariables();
+	std::vector<uint64_t> values( graph.getNodeCount() );
+	uint64_t slots[INPUT_SLOT_COUNT] = { 0 };
+	uint64_t mask = m_referenceTable.getLastWordMask();
+	int output = graph.getOutput( 0 );
+
+	pResult->mismatchCount = 0;
+	pResult->firstMismatch = 0;
+	pResult->firstMismatchKnown = true;
+	pResult->rowsChecked = 0;
+	if( pProgress && pProgress->isStopped() )
+		return false;
+
+	for( uint64_t i = startWord; i < endWord; i++ )
+	{
+		CTruthTable::fillInputSlots( referenceVariables, i, slots );
+		graph.evaluateWord( slots, &values[0] );
+
+		uint64_t difference = (values[output] ^ m_referenceTable.getWord( i )) & mask;
+		if( difference == 0 )
+			continue;
+		if( pResult->mismatchCount == 0 )
+			pResult->firstMismatch = (i << 6) + CountTrailingZeros( difference );
+		pResult->mismatchCount += CountSetBits( difference );
+	}
+	pResult->rowsChecked = std::min( (endWord - startWord) << 6, m_referenceTable.getRowCount() );
+	if( pProgress )
+		pProgress->addRows( pResult->rowsChecked );
+	return true;
+}
+
+void CGrader::gradeCandidate( const std::string& candidate, GradeResult *pResult, CTaskScheduler& scheduler, CProgress *pProgress ) const
+{
+	const std::vector<char>& referenceVariables = m_referenceTable.getUniqueVariables();
+	CEquationParser parser;
+	CExpressionGraph graph;
+	int parseError;
+
+	pResult->mismatchCount = 0;
+	pResult->firstMismatch = 0;
+	pResult->firstMismatchKnown = false;
+	pResult->rowsChecked = 0;
+
+	if( IsBlankLine( candidate ) ) {
+		pResult->result = GRADE_RESULT_BLANK;
+		return;
+	}
+	if( !parser.parse( candidate, &parseError ) || !graph.addEquation( parser, &parseError ) ) {
+		pResult->result = GRADE_RESULT_PARSE_ERROR;
+		return;
+	}
+	// Candidates may leave variables out, but not bring new ones in
+	const std::vector<char>& variables = graph.getUniqueVariables();
+	for( auto it = variables.begin(); it != variables.end(); it++ ) {
+		if( std::find( referenceVariables.begin(), referenceVariables.end(), (*it) ) == referenceVariables.end() ) {
+			pResult->result = GRADE_RESULT_VARIABLES;
+			return;
+		}
+	}
+
+	uint64_t wordCount = m_referenceTable.getWordCount();
+	bool complete;
+	if( wordCount <= GRADE_SPLIT_WORDS )
+		complete = this->gradeRange( graph, 0, wordCount, pResult, pProgress );
+	else
+	{
+		// The pieces land on this worker's deque, it runs them itself
+		// unless idle workers steal them first. Queued last to first, so
+		// the worker's newest first order checks the low rows first.
+		std::vector<GradeResult> pieces( (size_t)((wordCount + GRADE_SPLIT_WORDS - 1) / GRADE_SPLIT_WORDS) );
+		std::vector<char> finished( pieces.size(), 0 );
+		CTaskGroup group;
+		for( size_t i = pieces.size(); i-- > 0; )
+		{
+			uint64_t start = i * GRADE_SPLIT_WORDS;
+			uint64_t end = std::min( start + GRADE_SPLIT_WORDS, wordCount );
+			GradeResult *pPiece = &pieces[i];
+			char *pFinished = &finished[i];
+			scheduler.submit( group, [this, &graph, start, end, pPiece, pFinished, pProgress]() {
+				(*pFinished) = this->gradeRange( graph, start, end, pPiece, pProgress ) ? 1 : 0;
+			} );
+		}
+		scheduler.wait( group );
+
+		// Pieces can stop out of order, only the run of finished ones from
+		// the start counts as checked and can hold the first mismatch
+		complete = true;
+		for( size_t i = 0; i < pieces.size(); i++ )
+		{
+			if( !finished[i] ) {
+				complete = false;
+				continue;
+			}
+			if( pieces[i].mismatchCount != 0 && pResult->mismatchCount == 0 ) {
+				pResult->firstMismatch = pieces[i].firstMismatch;
+				pResult->firstMismatchKnown = complete;
+			}
+			pResult->mismatchCount += pieces[i].mismatchCount;
+			if( complete )
+				pResult->rowsChecked += pieces[i].rowsChecked;
+		}
+	}
+
+	if( pResult->mismatchCount != 0 )
+		pResult->result = GRADE_RESULT_NEQUAL;
+	else
+		pResult->result = (complete ? GRADE_RESULT_EQUAL : GRADE_RESULT_INCOMPLETE);
+}
+
+void CGrader::grade( const std::vector<std::string>& candidates, std::vector<GradeResult> *pResults, CTaskScheduler& scheduler, CProgress *pProgress ) const
+{
+	CTaskGroup group;
+
+	pResults->assign( candidates.size(), GradeResult() );
+	if( pProgress )
+		pProgress->setTotalRows( candidates.size() * m_referenceTable.getRowCount() );
+
+	for( size_t start = 0; start < candidates.size(); start += GRADE_BATCH_SIZE )
+	{
+		size_t end = std::min( start + GRADE_BATCH_SIZE, candidates.size() );
+		GradeResult *pBatch = &(*pResults)[0];
+		CTaskScheduler *pScheduler = &scheduler;
+		scheduler.submit( group, [this, &candidates, pBatch, start, end, pScheduler, pProgress]() {
+			for( size_t i = start; i < end; i++ )
+				this->gradeCandidate( candidates[i], &pBatch[i], *pScheduler, pProgress );
+		} );
+	}
+	scheduler.wait( group );
+}
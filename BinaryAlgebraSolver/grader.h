@@ -0,0 +1,57 @@
+#pragma once
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "expressiongraph.h"
+#include "progress.h"
+#include "scheduler.h"
+#include "truthtable.h"
+
+enum
+{
+	GRADE_RESULT_EQUAL,
+	GRADE_RESULT_NEQUAL,
+	GRADE_RESULT_PARSE_ERROR,
+	GRADE_RESULT_VARIABLES,
+	// Blank lines are skipped, not graded
+	GRADE_RESULT_BLANK,
+	// Stopped by the progress limits before a mismatch was found
+	GRADE_RESULT_INCOMPLETE
+};
+
+struct GradeResult
+{
+	int result;
+	uint64_t mismatchCount;
+	uint64_t firstMismatch;
+	// False if rows before firstMismatch went unchecked, so it is just one
+	// of the mismatches rather than the first
+	bool firstMismatchKnown;
+	// Rows 0 to rowsChecked - 1 were all compared
+	uint64_t rowsChecked;
+};
+
+// Checks many candidate equations against one reference. The reference
+// truth table is computed once and shared read-only by every worker.
+// Candidates over a large reference are split into word ranges, so one
+// huge candidate doesn't leave the other workers idle.
+class CGrader
+{
+private:
+	CTruthTable m_referenceTable;
+	std::string m_referenceEquation;
+
+	bool gradeRange( const CExpressionGraph& graph, uint64_t startWord, uint64_t endWord, GradeResult *pResult, CProgress *pProgress ) const;
+	void gradeCandidate( const std::string& candidate, GradeResult *pResult, CTaskScheduler& scheduler, CProgress *pProgress ) const;
+public:
+	CGrader();
+	~CGrader();
+
+	bool setReference( std::string equation, int *pError );
+	// Candidates the progress limits cut short come back incomplete, or not
+	// equal if a mismatch turned up in the rows that were checked
+	void grade( const std::vector<std::string>& candidates, std::vector<GradeResult> *pResults, CTaskScheduler& scheduler, CProgress *pProgress = 0 ) const;
+
+	inline const std::string& getReferenceEquation() const { return m_referenceEquation; }
+	inline const CTruthTable& getReferenceTable() const { return m_referenceTable; }
+};
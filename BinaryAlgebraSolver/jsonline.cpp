@@ -0,0 +1,253 @@
+#include "jsonline.h"
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+static void SkipSpaces( const std::string& line, size_t *pPos )
+{
+	while( *pPos < line.length() && isspace( (unsigned char)line[*pPos] ) )
+		(*pPos)++;
+}
+
+static bool ParseJsonString( const std::string& line, size_t *pPos, std::string *pValue )
+{
+	size_t pos = *pPos;
+
+	if( pos >= line.length() || line[pos] != '"' )
+		return false;
+	pos++;
+
+	pValue->clear();
+	while( pos < line.length() && line[pos] != '"' )
+	{
+		if( line[pos] != '\\' ) {
+			pValue->push_back( line[pos++] );
+			continue;
+		}
+		// Escape sequence
+		if( ++pos >= line.length() )
+			return false;
+		switch( line[pos] )
+		{
+		case 'n':
+			pValue->push_back( '\n' );
+			break;
+		case 't':
+			pValue->push_back( '\t' );
+			break;
+		case 'r':
+			pValue->push_back( '\r' );
+			break;
+		case 'b':
+			pValue->push_back( '\b' );
+			break;
+		case 'f':
+			pValue->push_back( '\f' );
+			break;
+		case 'u':
+			// Only the ASCII range means anything to the solver
+			if( pos + 4 >= line.length() )
+				return false;
+			pValue->push_back( (char)strtol( line.substr( pos + 1, 4 ).c_str(), 0, 16 ) );
+			pos += 4;
+			break;
+		default:
+			pValue->push_back( line[pos] );
+			break;
+		}
+		pos++;
+	}
+	if( pos >= line.length() )
+		return false;
+
+	*pPos = pos + 1;
+	return true;
+}
+
+// A bare value has to be a JSON number or literal to be echoed raw
+static bool IsJsonLiteral( const std::string& value )
+{
+	size_t pos = 0;
+
+	if( value == "true" || value == "false" || value == "null" )
+		return true;
+	if( pos < value.length() && value[pos] == '-' )
+		pos++;
+	if( pos >= value.length() || !isdigit( (unsigned char)value[pos] ) )
+		return false;
+	if( value[pos] == '0' )
+		pos++;
+	else {
+		while( pos < value.length() && isdigit( (unsigned char)value[pos] ) )
+			pos++;
+	}
+	if( pos < value.length() && value[pos] == '.' ) {
+		if( ++pos >= value.length() || !isdigit( (unsigned char)value[pos] ) )
+			return false;
+		while( pos < value.length() && isdigit( (unsigned char)value[pos] ) )
+			pos++;
+	}
+	if( pos < value.length() && (value[pos] == 'e' || value[pos] == 'E') ) {
+		pos++;
+		if( pos < value.length() && (value[pos] == '+' || value[pos] == '-') )
+			pos++;
+		if( pos >= value.length() || !isdigit( (unsigned char)value[pos] ) )
+			return false;
+		while( pos < value.length() && isdigit( (unsigned char)value[pos] ) )
+			pos++;
+	}
+	return pos == value.length();
+}
+
+bool ParseJsonObject( const std::string& line, std::map<std::string, std::string> *pFields, std::set<std::string> *pQuoted )
+{
+	size_t pos = 0;
+
+	pFields->clear();
+	if( pQuoted )
+		pQuoted->clear();
+	SkipSpaces( line, &pos );
+	if( pos >= line.length() || line[pos] != '{' )
+		return false;
+	pos++;
+	SkipSpaces( line, &pos );
+	if( pos < line.length() && line[pos] == '}' )
+		return true;
+
+	while( pos < line.length() )
+	{
+		std::string key, value;
+
+		SkipSpaces( line, &pos );
+		if( !ParseJsonString( line, &pos, &key ) )
+			return false;
+		SkipSpaces( line, &pos );
+		if( pos >= line.length() || line[pos] != ':' )
+			return false;
+		pos++;
+		SkipSpaces( line, &pos );
+
+		if( pos < line.length() && line[pos] == '"' ) {
+			if( !ParseJsonString( line, &pos, &value ) )
+				return false;
+			if( pQuoted )
+				pQuoted->insert( key );
+		}
+		else
+		{
+			// Bare value, runs until the next separator
+			size_t start = pos;
+			while( pos < line.length() && line[pos] != ',' && line[pos] != '}' && !isspace( (unsigned char)line[pos] ) ) {
+				if( line[pos] == '{' || line[pos] == '[' )
+					return false;
+				pos++;
+			}
+			value = line.substr( start, pos - start );
+			if( !IsJsonLiteral( value ) )
+				return false;
+			if( pQuoted )
+				pQuoted->erase( key );
+		}
+		(*pFields)[key] = value;
+
+		SkipSpaces( line, &pos );
+		if( pos < line.length() && line[pos] == ',' ) {
+			pos++;
+			continue;
+		}
+		if( pos < line.length() && line[pos] == '}' )
+			return true;
+		return false;
+	}
+
+	return false;
+}
+
+CJsonWriter::CJsonWriter() {
+	m_output = "{";
+}
+CJsonWriter::~CJsonWriter() {
+}
+
+void CJsonWriter::escapeString( const std::string& value, std::string *pOutput )
+{
+	pOutput->push_back( '"' );
+	for( auto it = value.begin(); it != value.end(); it++ )
+	{
+		switch( (*it) )
+		{
+		case '"':
+			pOutput->append( "\\\"" );
+			break;
+		case '\\':
+			pOutput->append( "\\\\" );
+			break;
+		case '\n':
+			pOutput->append( "\\n" );
+			break;
+		case '\t':
+			pOutput->append( "\\t" );
+			break;
+		case '\r':
+			pOutput->append( "\\r" );
+			break;
+		default:
+			if( (unsigned char)(*it) < 0x20 ) {
+				char buffer[8];
+				snprintf( buffer, sizeof( buffer ), "\\u%04x", (unsigned char)(*it) );
+				pOutput->append( buffer );
+			}
+			else
+				pOutput->push_back( (*it) );
+			break;
+		}
+	}
+	pOutput->push_back( '"' );
+}
+
+void CJsonWriter::addKey( const std::string& key )
+{
+	if( m_output.length() > 1 )
+		m_output.push_back( ',' );
+	CJsonWriter::escapeString( key, &m_output );
+	m_output.push_back( ':' );
+}
+
+void CJsonWriter::addString( const std::string& key, const std::string& value ) {
+	this->addKey( key );
+	CJsonWriter::escapeString( value, &m_output );
+}
+void CJsonWriter::addNumber( const std::string& key, int64_t value ) {
+	this->addKey( key );
+	m_output.append( std::to_string( (long long)value ) );
+}
+void CJsonWriter::addNumber( const std::string& key, double value )
+{
+	char buffer[32];
+	snprintf( buffer, sizeof( buffer ), "%.3f", value );
+	this->addKey( key );
+	m_output.append( buffer );
+}
+void CJsonWriter::addBool( const std::string& key, bool value ) {
+	this->addKey( key );
+	m_output.append( value ? "true" : "false" );
+}
+void CJsonWriter::addIntArray( const std::string& key, const std::vector<int>& values )
+{
+	this->addKey( key );
+	m_output.push_back( '[' );
+	for( auto it = values.begin(); it != values.end(); it++ ) {
+		if( it != values.begin() )
+			m_output.push_back( ',' );
+		m_output.append( std::to_string( (*it) ) );
+	}
+	m_output.push_back( ']' );
+}
+void CJsonWriter::addRaw( const std::string& key, const std::string& json ) {
+	this->addKey( key );
+	m_output.append( json );
+}
+
+std::string CJsonWriter::finish() const {
+	return m_output + "}";
+}
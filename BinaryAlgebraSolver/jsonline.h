@@ -0,0 +1,35 @@
+#pragma once
+#include <stdint.h>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+// Reads one flat JSON object, string values are unescaped and anything else
+// (numbers, true, false, null) is kept as its raw text. Nested objects and
+// arrays are not accepted. pQuoted gets the keys whose values were strings,
+// so a value can be written back the way it came in.
+bool ParseJsonObject( const std::string& line, std::map<std::string, std::string> *pFields, std::set<std::string> *pQuoted = 0 );
+
+// Builds one flat JSON object on a single line
+class CJsonWriter
+{
+private:
+	std::string m_output;
+
+	void addKey( const std::string& key );
+public:
+	static void escapeString( const std::string& value, std::string *pOutput );
+
+	CJsonWriter();
+	~CJsonWriter();
+
+	void addString( const std::string& key, const std::string& value );
+	void addNumber( const std::string& key, int64_t value );
+	void addNumber( const std::string& key, double value );
+	void addBool( const std::string& key, bool value );
+	void addIntArray( const std::string& key, const std::vector<int>& values );
+	void addRaw( const std::string& key, const std::string& json );
+
+	std::string finish() const;
+};
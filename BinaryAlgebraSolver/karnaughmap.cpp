@@ -1,7 +1,11 @@
 #include "karnaughmap.h"
 #include <algorithm>
 #include <ctype.h>
+#include <math.h>
+#include <stdarg.h>
+#include <stdio.h>
 #include <map>
+#include "stats.h"
 #include "util.h"
 
 CKarnaughMap::CKarnaughMap() {
@@ -115,11 +119,35 @@ int CKarnaughMap::getBoxTermNumber( std::string columnVal, std::string rowVal )
 	return ConvertBinaryToInt( binaryString );
 }
 
-void CKarnaughMap::print()
+// printf onto the end of a string
+static void AppendFormat( std::string *pOutput, const char *pFormat, ... )
+{
+	char buffer[256];
+	va_list args;
+	int length;
+
+	va_start( args, pFormat );
+	length = vsnprintf( buffer, sizeof( buffer ), pFormat, args );
+	va_end( args );
+	if( length < (int)sizeof( buffer ) ) {
+		pOutput->append( buffer, length );
+		return;
+	}
+
+	// Too long for the stack buffer, size it exactly
+	std::vector<char> large( length + 1 );
+	va_start( args, pFormat );
+	vsnprintf( &large[0], large.size(), pFormat, args );
+	va_end( args );
+	pOutput->append( &large[0], length );
+}
+
+void CKarnaughMap::format( std::string *pOutput )
 {
 	std::string offset, horizontal, boxPadLeft, boxPadRight;
 	std::vector<std::string> columnVals, rowVals;
-	printf( "\n" );
+	STATS_TIMER( STATS_PHASE_PRINT );
+	AppendFormat( pOutput, "\n" );
 
 	// Generate structure elements
 	offset.assign( m_rowVars.size()+1, ' ' );
@@ -148,21 +176,21 @@ void CKarnaughMap::print()
 		columnVals = GenerateGrayCode( m_columnVars.size() );
 
 	// Print column header
-	printf( "\t%s", offset.c_str() );
-	printf( "%s\n", std::string( m_columnVars.begin(), m_columnVars.end() ).c_str() );
+	AppendFormat( pOutput, "\t%s", offset.c_str() );
+	AppendFormat( pOutput, "%s\n", std::string( m_columnVars.begin(), m_columnVars.end() ).c_str() );
 
 	// Print column values
-	printf( "\t%s", offset.c_str() );
-	printf( "%s |", std::string( m_rowVars.size(), ' ' ).c_str() );
+	AppendFormat( pOutput, "\t%s", offset.c_str() );
+	AppendFormat( pOutput, "%s |", std::string( m_rowVars.size(), ' ' ).c_str() );
 	for( unsigned int i = 0; i < columnVals.size(); i++ ) {
-		printf( " %s |", columnVals[i].c_str() );
+		AppendFormat( pOutput, " %s |", columnVals[i].c_str() );
 	}
-	printf( "\n" );
-	printf( "\t%s %s\n", std::string( m_rowVars.begin(), m_rowVars.end() ).c_str(), horizontal.c_str() );
+	AppendFormat( pOutput, "\n" );
+	AppendFormat( pOutput, "\t%s %s\n", std::string( m_rowVars.begin(), m_rowVars.end() ).c_str(), horizontal.c_str() );
 
 	// Print rows
 	for( unsigned int i = 0; i < rowVals.size(); i++ ) {
-		printf( "\t%s%s |", offset.c_str(), rowVals[i].c_str() );
+		AppendFormat( pOutput, "\t%s%s |", offset.c_str(), rowVals[i].c_str() );
 		// Print values
 		for( unsigned int j = 0; j < columnVals.size(); j++ )
 		{
@@ -171,15 +199,22 @@ void CKarnaughMap::print()
 			// Get the box term number
 			boxTerm = this->getBoxTermNumber( columnVals[j], rowVals[i] );
 			// See if its a donkey or  minterm
+			STATS_INCREMENT( STAT_DONKEY_SCANS );
 			if( std::find( m_donkeyTerms.begin(), m_donkeyTerms.end(), boxTerm ) != m_donkeyTerms.end() )
-				printf( "%sX%s|", boxPadLeft.c_str(), boxPadRight.c_str() );
+				AppendFormat( pOutput, "%sX%s|", boxPadLeft.c_str(), boxPadRight.c_str() );
 			else if( std::find( m_minTerms.begin(), m_minTerms.end(), boxTerm ) != m_minTerms.end() )
-				printf( "%s1%s|", boxPadLeft.c_str(), boxPadRight.c_str() );
+				AppendFormat( pOutput, "%s1%s|", boxPadLeft.c_str(), boxPadRight.c_str() );
 			else
-				printf( "%s0%s|", boxPadLeft.c_str(), boxPadRight.c_str() );
+				AppendFormat( pOutput, "%s0%s|", boxPadLeft.c_str(), boxPadRight.c_str() );
 		}
-		printf( "\n" );
+		AppendFormat( pOutput, "\n" );
 	}
 
-	printf( "\n" );
+	AppendFormat( pOutput, "\n" );
+}
+void CKarnaughMap::print( FILE *pFile )
+{
+	std::string output;
+	this->format( &output );
+	fputs( output.c_str(), pFile );
 }
\ No newline at end of file
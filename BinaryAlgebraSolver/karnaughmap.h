@@ -1,4 +1,6 @@
 #pragma once
+#include <stdio.h>
+#include <string>
 #include <vector>
 
 enum
@@ -39,5 +41,6 @@ public:
 	bool setColumnVars( std::string columnVars);
 	bool setRowVars( std::string rowVars );
 
-	void print();
+	void format( std::string *pOutput );
+	void print( FILE *pFile = stdout );
 };
\ No newline at end of file
@@ -1,8 +1,313 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <chrono>
 #include <iostream>
+#include <new>
 #include <string>
 #include "util.h"
+#include "commandline.h"
 #include "equationparser.h"
+#include "equivalence.h"
+#include "expressiongraph.h"
 #include "karnaughmap.h"
+#include "shortcircuit.h"
+#include "stats.h"
+
+// Asks for the K-Map layout and prints it, false if the user gave up
+static bool PromptKarnaughMap( CKarnaughMap& kmap )
+{
+	std::string columnVars, rowVars, grayCodePrompt;
+	int varError;
+
+	while( kmap.isValidHeader( columnVars ) != HEADER_OK )
+	{
+		printf( "\nEnter variables for the columns: " );
+		std::getline( std::cin, columnVars );
+		if( (varError = kmap.isValidHeader( columnVars )) != HEADER_OK )
+		{
+			switch( varError )
+			{
+			case HEADER_ERROR_EMPTY:
+				printf( "No variables given!\n" );
+				return false;
+			case HEADER_ERROR_INVALID:
+				printf( "Invalid variables given!\n" );
+				break;
+			case HEADER_ERROR_DIMMISMATCH:
+				printf( "Does not match the dimension specifications (Rows and columns must have equal or off-by-one number of variables)\n" );
+				break;
+			case HEADER_ERROR_REPEAT:
+				printf( "Cannot repeat variables!" );
+				break;
+			}
+		}
+	}
+	kmap.setColumnVars( columnVars );
+	while( kmap.isValidHeader( rowVars ) != HEADER_OK )
+	{
+		printf( "\nEnter variables for the rows: " );
+		std::getline( std::cin, rowVars );
+		if( (varError = kmap.isValidHeader( rowVars )) != HEADER_OK )
+		{
+			switch( varError )
+			{
+			case HEADER_ERROR_EMPTY:
+				printf( "No variables given!\n" );
+				return false;
+			case HEADER_ERROR_INVALID:
+				printf( "Invalid variables given!\n" );
+				break;
+			case HEADER_ERROR_DIMMISMATCH:
+				printf( "Does not match the dimension specifications (Rows and columns must have equal or off-by-one number of variables)\n" );
+				break;
+			case HEADER_ERROR_REPEAT:
+				printf( "Cannot repeat variables!" );
+				break;
+			}
+		}
+	}
+	kmap.setRowVars( rowVars );
+
+	printf( "Row (r) or column (c) is control signals? (Press enter for neither):" );
+	std::getline( std::cin, grayCodePrompt );
+	if( grayCodePrompt == "r" ) {
+		printf( "ROW is control signals!\n" );
+		kmap.m_controlSignals = CONTROL_SIGNALS_ROW;
+	}
+	else if( grayCodePrompt == "c" ) {
+		printf( "COLUMN is control signals!\n" );
+		kmap.m_controlSignals = CONTROL_SIGNALS_COLUMN;
+	}
+
+
+	printf( "Generating K-Map (%s, %s)...\n", columnVars.c_str(), rowVars.c_str() );
+
+	kmap.print();
+
+	return true;
+}
+
+// Prints a term list in the same form as the single equation report
+static void PrintTerms( const char *pLabel, char symbol, const std::vector<int>& terms, const std::vector<int>& donkeyTerms )
+{
+	printf( "%s: %c(", pLabel, symbol );
+	for( auto it = terms.begin(); it != terms.end(); it++ ) {
+		printf( "%d", (*it) );
+		if( it + 1 != terms.end() )
+			printf( ", " );
+	}
+	if( donkeyTerms.size() > 0 )
+	{
+		printf( ") + d(" );
+		for( auto it = donkeyTerms.begin(); it != donkeyTerms.end(); it++ ) {
+			printf( "%d", (*it) );
+			if( it + 1 != donkeyTerms.end() )
+				printf( ", " );
+		}
+	}
+	printf( ")\n" );
+}
+
+// Solves a bank of equations over shared inputs in one pass
+static int SolveSystem()
+{
+	std::vector<CEquationParser> parsers;
+	std::vector<CTruthTable> tables;
+	std::vector<int> donkeyTerms;
+	std::string inputStr, donkeys;
+	CExpressionGraph graph;
+	int parseError;
+
+	printf( "Enter the equations of the system (hit enter twice to stop):\n" );
+	while( true )
+	{
+		printf( " F%d = ", (int)parsers.size() );
+		std::getline( std::cin, inputStr );
+		if( inputStr == "" )
+			break;
+
+		CEquationParser parser;
+		parser.parse( inputStr, &parseError );
+		if( parseError != PARSE_ERROR_OK ) {
+			printf( "ERROR: Invalid equation, try again\n" );
+			continue;
+		}
+		parsers.push_back( parser );
+	}
+	if( parsers.size() == 0 ) {
+		printf( "ERROR: No equation\n" );
+		printf( "\nPress any key to exit..." );
+		std::cin.get();
+		return 5;
+	}
+
+	// Merge everything into one graph
+	for( unsigned int i = 0; i < parsers.size(); i++ ) {
+		if( !graph.addEquation( parsers[i], &parseError ) ) {
+			printf( "ERROR: Unknown parse error contact devs\n" );
+			printf( "\nPress any key to exit..." );
+			std::cin.get();
+			return 666;
+		}
+	}
+	printf( "System OK! (%d outputs, %d variables, %d shared nodes)\n", graph.getOutputCount(), graph.getUniqueVariableCount(), graph.getNodeCount() );
+
+	printf( "Donkeys? (Separate by commas, press enter for none): " );
+	std::getline( std::cin, donkeys );
+	if( donkeys != "" )
+		donkeyTerms = ParseDonkeys( donkeys );
+
+	printf( "Evaluating system...\n" );
+	graph.evaluateTables( &tables );
+
+	// Truth table, one column per output
+	printf( " V\t| %s |", std::string( graph.getUniqueVariables().begin(), graph.getUniqueVariables().end() ).c_str() );
+	for( int i = 0; i < graph.getOutputCount(); i++ )
+		printf( " F%d", i );
+	printf( "\n" );
+	for( uint64_t i = 0; i < tables[0].getRowCount(); i++ )
+	{
+		printf( " %d\t| %s |", (int)i, ConvertIntToBinary( (int)i, graph.getUniqueVariableCount() ).c_str() );
+		for( unsigned int j = 0; j < tables.size(); j++ ) {
+			STATS_INCREMENT( STAT_DONKEY_SCANS );
+			if( std::find( donkeyTerms.begin(), donkeyTerms.end(), (int)i ) != donkeyTerms.end() )
+				printf( " %*s", (j < 10 ? 2 : 3), "X" );
+			else
+				printf( " %*d", (j < 10 ? 2 : 3), tables[j].get( i ) ? 1 : 0 );
+		}
+		printf( "\n" );
+	}
+
+	// Terms per output, donkeys removed
+	std::vector<std::vector<int>> minterms( tables.size() ), maxterms( tables.size() );
+	for( unsigned int i = 0; i < tables.size(); i++ )
+	{
+		char label[32];
+		std::vector<int> terms;
+
+		tables[i].getMinterms( &terms );
+		for( auto it = terms.begin(); it != terms.end(); it++ ) {
+			STATS_INCREMENT( STAT_DONKEY_SCANS );
+			if( std::find( donkeyTerms.begin(), donkeyTerms.end(), (*it) ) == donkeyTerms.end() )
+				minterms[i].push_back( (*it) );
+		}
+		tables[i].getMaxterms( &terms );
+		for( auto it = terms.begin(); it != terms.end(); it++ ) {
+			STATS_INCREMENT( STAT_DONKEY_SCANS );
+			if( std::find( donkeyTerms.begin(), donkeyTerms.end(), (*it) ) == donkeyTerms.end() )
+				maxterms[i].push_back( (*it) );
+		}
+
+		printf( "F%d = %s\n", i, graph.getOutputEquation( i ).c_str() );
+		snprintf( label, sizeof( label ), "Minterms (F%d)", i );
+		PrintTerms( label, 'm', minterms[i], donkeyTerms );
+		snprintf( label, sizeof( label ), "Maxterms (F%d)", i );
+		PrintTerms( label, 'M', maxterms[i], donkeyTerms );
+	}
+
+	// K-Maps on request, one per output
+	while( true )
+	{
+		std::string outputStr;
+		int output;
+
+		printf( "\nEnter an output number to generate its K-Map, or press enter to exit... " );
+		std::getline( std::cin, outputStr );
+		if( outputStr == "" )
+			break;
+		output = strtol( outputStr.c_str(), 0, 10 );
+		if( output < 0 || output >= graph.getOutputCount() ) {
+			printf( "No such output!\n" );
+			continue;
+		}
+
+		CKarnaughMap kmap;
+		kmap.m_uniqueVariables = graph.getUniqueVariables();
+		kmap.m_minTerms = minterms[output];
+		kmap.m_maxTerms = maxterms[output];
+		kmap.m_donkeyTerms = donkeyTerms;
+		if( !PromptKarnaughMap( kmap ) )
+			break;
+	}
+
+	return 0;
+}
+
+// Answers whether the equations are the same function without printing every row
+static int QuickCompare( CEquationParser& parser, CEquationParser& comparisonParser )
+{
+	static const char *stageNames[] = { "corner case", "random", "exhaustive" };
+	CExpressionGraph graph;
+	EquivalenceResult result;
+	int parseError;
+
+	graph.addEquation( parser, &parseError );
+	graph.addEquation( comparisonParser, &parseError );
+
+	auto start = std::chrono::high_resolution_clock::now();
+	CheckEquivalence( graph, 0, 1, &result );
+	auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>( std::chrono::high_resolution_clock::now() - start );
+
+	if( result.equal && result.rowsChecked == 0 )
+		printf( "EQUAL: both equations reduce to the same expression" );
+	else if( result.equal )
+		printf( "EQUAL: all %d inputs agree (%llu simulated)", parser.getMaxInputs(), (unsigned long long)result.rowsChecked );
+	else
+	{
+		std::string input = ConvertIntToBinary( (int)result.counterexample, graph.getUniqueVariableCount() );
+		bool evalResult, comparisonResult;
+
+		parser.evaluate( input, &evalResult, &parseError );
+		comparisonParser.evaluate( input, &comparisonResult, &parseError );
+		printf( "NEQUAL: input %d (%s) gives C: %s\tE: %s\n", (int)result.counterexample, input.c_str(), (comparisonResult ? "TRUE" : "FALSE"), (evalResult ? "TRUE" : "FALSE") );
+		printf( "Found by %s search after %llu inputs", stageNames[result.stage], (unsigned long long)result.rowsChecked );
+	}
+	printf( " in %lld us\n", (long long)elapsed.count() );
+
+	printf( "\nPress any key to exit..." );
+	std::cin.get();
+	return 0;
+}
+
+// Lowers an equation for evaluating one row at a time, with the operand
+// order tuned on the rows it is about to see. False if the parser has to
+// evaluate them instead.
+static bool CompileShortCircuit( CEquationParser& parser, const std::vector<uint64_t>& rows, CShortCircuitProgram *pProgram )
+{
+	CExpressionGraph graph;
+	int parseError;
+
+	if( !graph.addEquation( parser, &parseError ) || !pProgram->compile( graph, 0 ) )
+		return false;
+	pProgram->profile( &rows[0], rows.size() );
+	return true;
+}
+
+#ifdef ENABLE_STATS
+// Allocation counting for --stats. It lives here rather than in the core
+// library so programs embedding the library keep their own allocator.
+void *operator new( size_t size )
+{
+	void *pMemory = malloc( size ? size : 1 );
+	if( !pMemory )
+		throw std::bad_alloc();
+	STATS_INCREMENT( STAT_ALLOCATIONS );
+	STATS_ADD( STAT_BYTES_ALLOCATED, size );
+	return pMemory;
+}
+void operator delete( void *pMemory ) noexcept {
+	free( pMemory );
+}
+void operator delete( void *pMemory, size_t ) noexcept {
+	free( pMemory );
+}
+#endif
+
+static int g_statsReport = STATS_REPORT_NONE;
+static void PrintStatsAtExit() {
+	PrintStats( stderr, g_statsReport );
+}
 
 int main( int argc, char *argv[] )
 {
@@ -13,6 +318,25 @@ int main( int argc, char *argv[] )
 	std::vector<int> maxterm, maxtermComparison;
 	std::vector<int> donkeyTerms, donkeyTermsComparison;
 
+	// --stats works with every mode, so take it out before anything else looks
+	for( int i = 1; i < argc; i++ )
+	{
+		std::string arg = argv[i];
+		if( arg != "--stats" && arg != "--stats=json" )
+			continue;
+		g_statsReport = (arg == "--stats" ? STATS_REPORT_TEXT : STATS_REPORT_JSON);
+		for( int j = i; j < argc - 1; j++ )
+			argv[j] = argv[j + 1];
+		argc--;
+		i--;
+	}
+	if( g_statsReport != STATS_REPORT_NONE )
+		atexit( PrintStatsAtExit );
+
+	// Anything on the command line is a batch mode
+	if( argc > 1 )
+		return RunCommandLine( argc, argv );
+
 	printf( "\n  Binary Algebra Solver\n" );
 	printf( "  by Timothy Volpe (c) 2017\n" );
 	printf( "  v0.4\n\n" );
@@ -21,6 +345,7 @@ int main( int argc, char *argv[] )
 
 	// Get an equation from the user
 	printf( "Enter \'f\' to compare to file\n" );
+	printf( "Enter \'s\' to solve a system of equations\n" );
 	printf( "Enter an equation: " );
 	std::getline( std::cin, userEq );
 	if( userEq == "" ) {
@@ -29,11 +354,17 @@ int main( int argc, char *argv[] )
 		std::cin.get();
 		return 5;
 	}
+	else if( userEq[0] == 's' )
+		return SolveSystem();
 	else if( userEq[0] == 'f' )
 	{
 		// Load the equation from file
 		FILE *file;
+#ifdef _MSC_VER
 		fopen_s( &file, "equation.txt", "r" );
+#else
+		file = fopen( "equation.txt", "r" );
+#endif
 		if( file ) {
 			char buff[512];
 			fgets( buff, 512, file );
@@ -142,6 +473,8 @@ int main( int argc, char *argv[] )
 		printf( "%c", parser.getUniqueVariables()[i] );
 	}
 	printf( " (Enter \'i\' to use 0-%d as inputs)\n", parser.getMaxInputs() );
+	if( comparisonEq != "" )
+		printf( " (Enter \'q\' to only check if the equations are equivalent)\n" );
 	userInputs.clear();
 	while( (int)userInputs.size() < parser.getMaxInputs() )
 	{
@@ -149,6 +482,8 @@ int main( int argc, char *argv[] )
 		std::getline( std::cin, inputStr );
 		if( inputStr == "" )
 			break;
+		else if( inputStr[0] == 'q' && comparisonEq != "" )
+			return QuickCompare( parser, comparisonParser );
 		else if( inputStr[0] == 'i' ) {
 			// Fill in the rest with the remaining inputs incrementing
 			for( int j = userInputs.size(); j < parser.getMaxInputs(); j++ ) {
@@ -185,9 +520,20 @@ int main( int argc, char *argv[] )
 		donkeyTerms = ParseDonkeys( donkeys );
 
 	printf( "Evaluating equation...\n" );
+	std::vector<uint64_t> inputRows;
+	CShortCircuitProgram program, comparisonProgram;
+	for( unsigned int i = 0; i < userInputs.size(); i++ )
+		inputRows.push_back( strtoull( userInputs[i].c_str(), 0, 2 ) );
+	bool shortCircuit = CompileShortCircuit( parser, inputRows, &program );
+	bool comparisonShortCircuit = (comparisonEq != "" && CompileShortCircuit( comparisonParser, inputRows, &comparisonProgram ));
 	for( unsigned int i = 0; i < userInputs.size(); i++ )
 	{
-		parser.evaluate( userInputs[i], &evalResult, &parseError );
+		if( shortCircuit ) {
+			evalResult = program.evaluate( inputRows[i] );
+			parseError = PARSE_ERROR_OK;
+		}
+		else
+			parser.evaluate( userInputs[i], &evalResult, &parseError );
 		switch( parseError )
 		{
 		case PARSE_ERROR_SYNTAX:
@@ -204,7 +550,12 @@ int main( int argc, char *argv[] )
 		}
 		if( comparisonEq != "" )
 		{
-			comparisonParser.evaluate( userInputs[i], &comparisonResult, &comparisonError );
+			if( comparisonShortCircuit ) {
+				comparisonResult = comparisonProgram.evaluate( inputRows[i] );
+				comparisonError = PARSE_ERROR_OK;
+			}
+			else
+				comparisonParser.evaluate( userInputs[i], &comparisonResult, &comparisonError );
 			switch( comparisonError )
 			{
 			case PARSE_ERROR_SYNTAX:
@@ -223,6 +574,7 @@ int main( int argc, char *argv[] )
 		if( comparisonEq != "" ) {
 			printf( "Result %d:\t %s (C: %s\tE: %s)\n", i, ((evalResult == comparisonResult) ? "EQUAL " : "NEQUAL"), (comparisonResult ? "TRUE" : "FALSE"), (evalResult ? "TRUE" : "FALSE") );
 			// Make sure it isn't a donkey
+			STATS_INCREMENT( STAT_DONKEY_SCANS );
 			if( std::find( donkeyTerms.begin(), donkeyTerms.end(), i ) == donkeyTerms.end() )
 			{
 				if( comparisonResult )
@@ -235,6 +587,7 @@ int main( int argc, char *argv[] )
 			printf( "Result %d:\t %s\n", i, (evalResult ? "TRUE" : "FALSE") );
 
 		// Make sure it isn't a donkey
+		STATS_INCREMENT( STAT_DONKEY_SCANS );
 		if( std::find( donkeyTerms.begin(), donkeyTerms.end(), i ) == donkeyTerms.end() )
 		{
 			if( evalResult )
@@ -325,8 +678,7 @@ int main( int argc, char *argv[] )
 
 	// K-Maps
 	CKarnaughMap kmap;
-	std::string exitString, columnVars, rowVars, grayCodePrompt;
-	int varError;
+	std::string exitString;
 
 	printf( "\nEnter \'k' to generate a K-Map, or press enter to exit... " );
 	std::getline( std::cin, exitString );
@@ -338,70 +690,8 @@ int main( int argc, char *argv[] )
 		kmap.m_maxTerms = maxterm;
 		kmap.m_donkeyTerms = donkeyTerms;
 
-		while( kmap.isValidHeader( columnVars ) != HEADER_OK )
-		{
-			printf( "\nEnter variables for the columns: " );
-			std::getline( std::cin, columnVars );
-			if( (varError = kmap.isValidHeader( columnVars )) != HEADER_OK )
-			{
-				switch( varError )
-				{
-				case HEADER_ERROR_EMPTY:
-					printf( "No variables given!\n" );
-					return 0;
-				case HEADER_ERROR_INVALID:
-					printf( "Invalid variables given!\n" );
-					break;
-				case HEADER_ERROR_DIMMISMATCH:
-					printf( "Does not match the dimension specifications (Rows and columns must have equal or off-by-one number of variables)\n" );
-					break;
-				case HEADER_ERROR_REPEAT:
-					printf( "Cannot repeat variables!" );
-					break;
-				}
-			}
-		}
-		kmap.setColumnVars( columnVars );
-		while( kmap.isValidHeader( rowVars ) != HEADER_OK )
-		{
-			printf( "\nEnter variables for the rows: " );
-			std::getline( std::cin, rowVars );
-			if( (varError = kmap.isValidHeader( rowVars )) != HEADER_OK )
-			{
-				switch( varError )
-				{
-				case HEADER_ERROR_EMPTY:
-					printf( "No variables given!\n" );
-					return 0;
-				case HEADER_ERROR_INVALID:
-					printf( "Invalid variables given!\n" );
-					break;
-				case HEADER_ERROR_DIMMISMATCH:
-					printf( "Does not match the dimension specifications (Rows and columns must have equal or off-by-one number of variables)\n" );
-					break;
-				case HEADER_ERROR_REPEAT:
-					printf( "Cannot repeat variables!" );
-					break;
-				}
-			}
-		}
-		kmap.setRowVars( rowVars );
-
-		printf( "Row (r) or column (c) is control signals? (Press enter for neither):" );
-		std::getline( std::cin, grayCodePrompt );
-		if( grayCodePrompt == "r" ) {
-			printf( "ROW is control signals!\n" );
-			kmap.m_controlSignals = CONTROL_SIGNALS_ROW;
-		}
-		else if( grayCodePrompt == "c" ) {
-			printf( "COLUMN is control signals!\n" );
-			kmap.m_controlSignals = CONTROL_SIGNALS_COLUMN;
-		}
-
-
-		printf( "Generating K-Map (%s, %s)...\n", columnVars.c_str(), rowVars.c_str() );
-
-		kmap.print();
+		if( !PromptKarnaughMap( kmap ) )
+			return 0;
 
 		printf( "\nPress any key to exit..." );
 		std::cin.get();
@@ -0,0 +1,104 @@
+#include "mappedfile.h"
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+CMappedFile::CMappedFile()
+{
+	m_pData = 0;
+	m_size = 0;
+#ifdef _WIN32
+	m_file = INVALID_HANDLE_VALUE;
+	m_mapping = 0;
+#else
+	m_descriptor = -1;
+#endif
+}
+CMappedFile::~CMappedFile() {
+	this->close();
+}
+
+bool CMappedFile::open( const std::string& path )
+{
+	this->close();
+
+#ifdef _WIN32
+	LARGE_INTEGER size;
+
+	m_file = CreateFileA( path.c_str(), GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, 0 );
+	if( m_file == INVALID_HANDLE_VALUE )
+		return false;
+	if( !GetFileSizeEx( (HANDLE)m_file, &size ) ) {
+		this->close();
+		return false;
+	}
+	m_size = (size_t)size.QuadPart;
+	// Empty files can't be mapped, but they're valid
+	if( m_size == 0 ) {
+		m_pData = "";
+		return true;
+	}
+	m_mapping = CreateFileMappingA( (HANDLE)m_file, 0, PAGE_READONLY, 0, 0, 0 );
+	if( !m_mapping ) {
+		this->close();
+		return false;
+	}
+	m_pData = (const char*)MapViewOfFile( (HANDLE)m_mapping, FILE_MAP_READ, 0, 0, 0 );
+	if( !m_pData ) {
+		this->close();
+		return false;
+	}
+#else
+	struct stat status;
+
+	m_descriptor = ::open( path.c_str(), O_RDONLY );
+	if( m_descriptor == -1 )
+		return false;
+	if( fstat( m_descriptor, &status ) != 0 ) {
+		this->close();
+		return false;
+	}
+	m_size = (size_t)status.st_size;
+	if( m_size == 0 ) {
+		m_pData = "";
+		return true;
+	}
+	void *pMapping = mmap( 0, m_size, PROT_READ, MAP_PRIVATE, m_descriptor, 0 );
+	if( pMapping == MAP_FAILED ) {
+		this->close();
+		return false;
+	}
+	// Read front to back, let the kernel read ahead
+	madvise( pMapping, m_size, MADV_SEQUENTIAL );
+	m_pData = (const char*)pMapping;
+#endif
+
+	return true;
+}
+
+void CMappedFile::close()
+{
+#ifdef _WIN32
+	if( m_pData && m_size > 0 )
+		UnmapViewOfFile( m_pData );
+	if( m_mapping )
+		CloseHandle( (HANDLE)m_mapping );
+	if( m_file != INVALID_HANDLE_VALUE )
+		CloseHandle( (HANDLE)m_file );
+	m_file = INVALID_HANDLE_VALUE;
+	m_mapping = 0;
+#else
+	if( m_pData && m_size > 0 )
+		munmap( (void*)m_pData, m_size );
+	if( m_descriptor != -1 )
+		::close( m_descriptor );
+	m_descriptor = -1;
+#endif
+	m_pData = 0;
+	m_size = 0;
+}
@@ -0,0 +1,27 @@
+#pragma once
+#include <stddef.h>
+#include <string>
+
+// A whole file mapped read-only into memory, so large inputs are paged in
+// by the OS as they're read instead of copied into buffers
+class CMappedFile
+{
+private:
+	const char *m_pData;
+	size_t m_size;
+#ifdef _WIN32
+	void *m_file;
+	void *m_mapping;
+#else
+	int m_descriptor;
+#endif
+public:
+	CMappedFile();
+	~CMappedFile();
+
+	bool open( const std::string& path );
+	void close();
+
+	inline const char *getData() const { return m_pData; }
+	inline size_t getSize() const { return m_size; }
+};
@@ -0,0 +1,225 @@
+#include "pipeline.h"
+#include <string.h>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "stats.h"
+#include "util.h"
+
+static const char *g_stageNames[PIPELINE_STAGE_COUNT] = { "reader", "parser", "evaluator", "writer" };
+
+static uint64_t GetTimeNs() {
+	return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now().time_since_epoch() ).count();
+}
+
+CPipeline::CPipeline() :
+	m_parseQueue( PIPELINE_QUEUE_CAPACITY ),
+	m_evaluateQueue( PIPELINE_QUEUE_CAPACITY ),
+	m_writeQueue( PIPELINE_QUEUE_CAPACITY )
+{
+	memset( m_stats, 0, sizeof( m_stats ) );
+	m_elapsedNs = 0;
+}
+CPipeline::~CPipeline() {
+}
+
+void CPipeline::push( CSpscQueue<ItemPtr>& queue, ItemPtr& pItem, PipelineStageStats *pStats )
+{
+	// A full queue means the next stage is behind, wait for it
+	if( !queue.tryPush( pItem ) ) {
+		uint64_t start = GetTimeNs();
+		for( int spin = 0; !queue.tryPush( pItem ); spin++ ) {
+			if( spin < PIPELINE_SPIN_COUNT )
+				std::this_thread::yield();
+			else
+				queue.waitForSpace();
+		}
+		pStats->stalledNs += GetTimeNs() - start;
+	}
+
+	uint64_t depth = queue.size();
+	pStats->queueDepthSum += depth;
+	if( depth > pStats->maxQueueDepth )
+		pStats->maxQueueDepth = depth;
+}
+bool CPipeline::pop( CSpscQueue<ItemPtr>& queue, ItemPtr *pItem, PipelineStageStats *pStats )
+{
+	if( queue.tryPop( pItem ) )
+		return true;
+
+	uint64_t start = GetTimeNs();
+	for( int spin = 0; ; spin++ )
+	{
+		if( queue.tryPop( pItem ) )
+			break;
+		// Only finished once it's closed and nothing slipped in before that
+		if( queue.isClosed() ) {
+			if( queue.tryPop( pItem ) )
+				break;
+			pStats->stalledNs += GetTimeNs() - start;
+			return false;
+		}
+		if( spin < PIPELINE_SPIN_COUNT )
+			std::this_thread::yield();
+		else
+			queue.waitForItem();
+	}
+	pStats->stalledNs += GetTimeNs() - start;
+	return true;
+}
+
+void CPipeline::readerMain( FILE *pInput )
+{
+	PipelineStageStats *pStats = &m_stats[PIPELINE_STAGE_READER];
+	std::vector<char> buffer( 4096 );
+	std::string line;
+	uint64_t index = 0;
+	uint64_t start = GetTimeNs();
+
+	while( fgets( &buffer[0], (int)buffer.size(), pInput ) )
+	{
+		line += &buffer[0];
+		if( line[line.length() - 1] != '\n' && !feof( pInput ) )
+			continue;
+		while( !line.empty() && (line[line.length() - 1] == '\n' || line[line.length() - 1] == '\r') )
+			line.erase( line.length() - 1 );
+		if( IsBlankLine( line ) ) {
+			line.clear();
+			index++;
+			continue;
+		}
+
+		ItemPtr pItem( new PipelineItem() );
+		pItem->index = index++;
+		pItem->line.swap( line );
+		pItem->ok = false;
+		pItem->mintermCount = 0;
+		pStats->items++;
+		this->push( m_parseQueue, pItem, pStats );
+	}
+	m_parseQueue.close();
+
+	pStats->busyNs = GetTimeNs() - start - pStats->stalledNs;
+}
+
+void CPipeline::parserMain()
+{
+	PipelineStageStats *pStats = &m_stats[PIPELINE_STAGE_PARSER];
+	ItemPtr pItem;
+
+	while( this->pop( m_parseQueue, &pItem, pStats ) )
+	{
+		uint64_t start = GetTimeNs();
+		int parseError;
+		pItem->ok = pItem->parser.parse( pItem->line, &parseError ) && pItem->graph.addEquation( pItem->parser, &parseError );
+		pStats->busyNs += GetTimeNs() - start;
+		pStats->items++;
+		this->push( m_evaluateQueue, pItem, pStats );
+	}
+	m_evaluateQueue.close();
+}
+
+void CPipeline::evaluatorMain()
+{
+	PipelineStageStats *pStats = &m_stats[PIPELINE_STAGE_EVALUATOR];
+	std::vector<CTruthTable> tables;
+	ItemPtr pItem;
+
+	while( this->pop( m_evaluateQueue, &pItem, pStats ) )
+	{
+		uint64_t start = GetTimeNs();
+		if( pItem->ok ) {
+			pItem->graph.evaluateTables( &tables );
+			if( pItem->graph.getUniqueVariables().size() > PIPELINE_MAX_LIST_VARIABLES )
+				pItem->mintermCount = tables[0].countOnes();
+			else
+				pItem->table = std::move( tables[0] );
+		}
+		pStats->busyNs += GetTimeNs() - start;
+		pStats->items++;
+		this->push( m_writeQueue, pItem, pStats );
+	}
+	m_writeQueue.close();
+}
+
+void CPipeline::writerMain( FILE *pOutput )
+{
+	PipelineStageStats *pStats = &m_stats[PIPELINE_STAGE_WRITER];
+	std::vector<int> terms;
+	std::string report;
+	ItemPtr pItem;
+
+	while( this->pop( m_writeQueue, &pItem, pStats ) )
+	{
+		uint64_t start = GetTimeNs();
+		STATS_TIMER( STATS_PHASE_PRINT );
+		const std::vector<char>& variables = pItem->graph.getUniqueVariables();
+
+		report = "Equation " + std::to_string( (unsigned long long)pItem->index ) + ": ";
+		if( !pItem->ok )
+			report += "ERROR: Invalid equation\n";
+		else
+		{
+			report += pItem->parser.getCleanEquation() + " (" + std::string( variables.begin(), variables.end() ) + ")\n";
+			if( variables.size() > PIPELINE_MAX_LIST_VARIABLES )
+				report += "Minterms: " + std::to_string( (unsigned long long)pItem->mintermCount ) + " of " + std::to_string( 1ull << variables.size() ) + "\n";
+			else
+			{
+				pItem->table.getMinterms( &terms );
+				report += "Minterms: m(";
+				for( auto it = terms.begin(); it != terms.end(); it++ ) {
+					if( it != terms.begin() )
+						report += ", ";
+					report += std::to_string( (*it) );
+				}
+				pItem->table.getMaxterms( &terms );
+				report += ")\nMaxterms: M(";
+				for( auto it = terms.begin(); it != terms.end(); it++ ) {
+					if( it != terms.begin() )
+						report += ", ";
+					report += std::to_string( (*it) );
+				}
+				report += ")\n";
+			}
+		}
+		fputs( report.c_str(), pOutput );
+		pItem.reset();
+
+		pStats->busyNs += GetTimeNs() - start;
+		pStats->items++;
+	}
+	fflush( pOutput );
+}
+
+void CPipeline::run( FILE *pInput, FILE *pOutput )
+{
+	uint64_t start = GetTimeNs();
+
+	std::thread parser( &CPipeline::parserMain, this );
+	std::thread evaluator( &CPipeline::evaluatorMain, this );
+	std::thread writer( &CPipeline::writerMain, this, pOutput );
+	this->readerMain( pInput );
+	parser.join();
+	evaluator.join();
+	writer.join();
+
+	m_elapsedNs = GetTimeNs() - start;
+}
+
+void CPipeline::printStats( FILE *pFile )
+{
+	double elapsed = m_elapsedNs / 1e9;
+
+	fprintf( pFile, "Pipeline: %llu equations in %.3f s\n", (unsigned long long)m_stats[PIPELINE_STAGE_WRITER].items, elapsed );
+	fprintf( pFile, " Stage\t\t| Items\t| Busy s\t| Stalled s\t| Items/s\t| Out queue avg/max\n" );
+	for( int i = 0; i < PIPELINE_STAGE_COUNT; i++ )
+	{
+		const PipelineStageStats& stats = m_stats[i];
+		fprintf( pFile, " %-10s\t| %llu\t| %.3f\t\t| %.3f\t\t| %.0f\t\t| ", g_stageNames[i], (unsigned long long)stats.items,
+			stats.busyNs / 1e9, stats.stalledNs / 1e9, (stats.busyNs > 0 ? stats.items / (stats.busyNs / 1e9) : 0.0) );
+		if( i == PIPELINE_STAGE_WRITER )
+			fprintf( pFile, "-\n" );
+		else
+			fprintf( pFile, "%.1f/%llu\n", (stats.items > 0 ? (double)stats.queueDepthSum / stats.items : 0.0), (unsigned long long)stats.maxQueueDepth );
+	}
+}
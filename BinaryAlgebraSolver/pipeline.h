@@ -0,0 +1,79 @@
+#pragma once
+#include <stdint.h>
+#include <stdio.h>
+#include <memory>
+#include <string>
+#include "equationparser.h"
+#include "expressiongraph.h"
+#include "spscqueue.h"
+#include "truthtable.h"
+
+// Slots between two neighbouring stages
+#define PIPELINE_QUEUE_CAPACITY 256
+// Yields on a full or empty queue before the stage goes to sleep on it
+#define PIPELINE_SPIN_COUNT 64
+// Past this many variables only the minterm count is written
+#define PIPELINE_MAX_LIST_VARIABLES 16
+
+enum
+{
+	PIPELINE_STAGE_READER,
+	PIPELINE_STAGE_PARSER,
+	PIPELINE_STAGE_EVALUATOR,
+	PIPELINE_STAGE_WRITER,
+	PIPELINE_STAGE_COUNT
+};
+
+struct PipelineStageStats
+{
+	uint64_t items;
+	uint64_t busyNs;
+	uint64_t stalledNs;
+	// Depth of the queue the stage pushes into, sampled on every push
+	uint64_t maxQueueDepth;
+	uint64_t queueDepthSum;
+};
+
+struct PipelineItem
+{
+	uint64_t index;
+	std::string line;
+	bool ok;
+	CEquationParser parser;
+	CExpressionGraph graph;
+	// Past PIPELINE_MAX_LIST_VARIABLES only the count is kept, so the write
+	// queue never holds more than small tables
+	CTruthTable table;
+	uint64_t mintermCount;
+};
+
+// Solves a file of equations, one per line, with the reading, parsing,
+// evaluation and report writing each on their own thread. The stages are
+// joined by bounded lock-free queues, so a stage that gets ahead waits for
+// the next one and the reports come out in input order. Reports are
+// numbered by input line and blank lines are skipped.
+class CPipeline
+{
+private:
+	typedef std::unique_ptr<PipelineItem> ItemPtr;
+
+	CSpscQueue<ItemPtr> m_parseQueue;
+	CSpscQueue<ItemPtr> m_evaluateQueue;
+	CSpscQueue<ItemPtr> m_writeQueue;
+	PipelineStageStats m_stats[PIPELINE_STAGE_COUNT];
+	uint64_t m_elapsedNs;
+
+	void push( CSpscQueue<ItemPtr>& queue, ItemPtr& pItem, PipelineStageStats *pStats );
+	bool pop( CSpscQueue<ItemPtr>& queue, ItemPtr *pItem, PipelineStageStats *pStats );
+
+	void readerMain( FILE *pInput );
+	void parserMain();
+	void evaluatorMain();
+	void writerMain( FILE *pOutput );
+public:
+	CPipeline();
+	~CPipeline();
+
+	void run( FILE *pInput, FILE *pOutput );
+	void printStats( FILE *pFile );
+};
@@ -0,0 +1,419 @@
+#include "pla.h"
+#include <stdlib.h>
+#include <string.h>
+#include "mappedfile.h"
+
+// Line by line over a mapped buffer, without the line break or a CR
+static bool NextLine( const char **ppCursor, const char *pEnd, const char **ppLine, const char **ppLineEnd )
+{
+	if( *ppCursor >= pEnd )
+		return false;
+	const char *pBreak = (const char*)memchr( *ppCursor, '\n', pEnd - *ppCursor );
+	*ppLine = *ppCursor;
+	*ppLineEnd = (pBreak ? pBreak : pEnd);
+	*ppCursor = (pBreak ? pBreak + 1 : pEnd);
+	if( *ppLineEnd > *ppLine && (*ppLineEnd)[-1] == '\r' )
+		(*ppLineEnd)--;
+	return true;
+}
+
+static inline bool IsBlank( char ch ) {
+	return (ch == ' ' || ch == '\t' || ch == '|');
+}
+
+// Whitespace separated words of a keyword line, those are few and short
+static void SplitWords( const char *pLine, const char *pLineEnd, std::vector<std::string> *pWords )
+{
+	pWords->clear();
+	while( pLine < pLineEnd )
+	{
+		while( pLine < pLineEnd && IsBlank( *pLine ) )
+			pLine++;
+		const char *pStart = pLine;
+		while( pLine < pLineEnd && !IsBlank( *pLine ) )
+			pLine++;
+		if( pLine > pStart )
+			pWords->push_back( std::string( pStart, pLine ) );
+	}
+}
+
+static std::string LineError( uint64_t lineNumber, const char *pMessage ) {
+	return "Line " + std::to_string( (unsigned long long)lineNumber ) + ": " + pMessage;
+}
+
+CPlaFile::CPlaFile()
+{
+	m_inputCount = 0;
+	m_outputCount = 0;
+	m_type = PLA_TYPE_FD;
+	m_cubeCount = 0;
+	m_raw = false;
+}
+CPlaFile::~CPlaFile() {
+}
+
+bool CPlaFile::load( const std::string& path, std::string *pError )
+{
+	CMappedFile file;
+	if( !file.open( path ) ) {
+		*pError = "Could not open " + path;
+		return false;
+	}
+	return this->parse( file.getData(), file.getSize(), pError );
+}
+
+bool CPlaFile::parse( const char *pData, size_t size, std::string *pError )
+{
+	const char *pCursor = pData, *pEnd = pData + size, *pLine, *pLineEnd;
+
+	m_variables.clear();
+	m_inputNames.clear();
+	m_outputNames.clear();
+	m_onSets.clear();
+	m_dcSets.clear();
+	m_offSets.clear();
+	m_inputCount = 0;
+	m_outputCount = 0;
+	m_type = PLA_TYPE_FD;
+	m_cubeCount = 0;
+
+	// Keywords or an input and output field mean PLA, one bare field is
+	// a raw table
+	m_raw = false;
+	while( NextLine( &pCursor, pEnd, &pLine, &pLineEnd ) )
+	{
+		while( pLine < pLineEnd && IsBlank( *pLine ) )
+			pLine++;
+		if( pLine == pLineEnd || *pLine == '#' )
+			continue;
+		if( *pLine != '.' ) {
+			std::vector<std::string> words;
+			SplitWords( pLine, pLineEnd, &words );
+			m_raw = (words.size() == 1);
+		}
+		break;
+	}
+
+	if( m_raw )
+		return this->parseRaw( pData, size, pError );
+	return this->parsePla( pData, size, pError );
+}
+
+bool CPlaFile::allocate( int inputCount, int outputCount, std::string *pError )
+{
+	if( inputCount < 0 ) {
+		*pError = "Negative input count";
+		return false;
+	}
+	if( inputCount > PLA_MAX_INPUTS ) {
+		*pError = "More than " + std::to_string( PLA_MAX_INPUTS ) + " inputs";
+		return false;
+	}
+	if( outputCount < 1 ) {
+		*pError = "No outputs";
+		return false;
+	}
+	uint64_t tablesPerOutput = (m_type == PLA_TYPE_FR || m_type == PLA_TYPE_FDR ? 3 : 2);
+	uint64_t tableBytes = (uint64_t)outputCount * tablesPerOutput * CTruthTable::getWordCount( inputCount ) * sizeof( uint64_t );
+	if( tableBytes > PLA_MAX_TABLE_BYTES ) {
+		*pError = "Tables for " + std::to_string( outputCount ) + " outputs over " + std::to_string( inputCount ) + " inputs would need more than " +
+			std::to_string( PLA_MAX_TABLE_BYTES >> 20 ) + " MB";
+		return false;
+	}
+
+	m_inputCount = inputCount;
+	m_outputCount = outputCount;
+	m_variables.clear();
+	for( int i = 0; i < inputCount; i++ )
+		m_variables.push_back( (char)('A' + i) );
+	// Names that weren't given default to the letters and f0, f1...
+	for( int i = (int)m_inputNames.size(); i < inputCount; i++ )
+		m_inputNames.push_back( std::string( 1, m_variables[i] ) );
+	for( int i = (int)m_outputNames.size(); i < outputCount; i++ )
+		m_outputNames.push_back( "f" + std::to_string( i ) );
+
+	m_onSets.assign( outputCount, CTruthTable( m_variables ) );
+	m_dcSets.assign( outputCount, CTruthTable( m_variables ) );
+	if( m_type == PLA_TYPE_FR || m_type == PLA_TYPE_FDR )
+		m_offSets.assign( outputCount, CTruthTable( m_variables ) );
+	return true;
+}
+
+// Sets every row of the cube in the tables its outputs ask for. The low
+// six row bits pick lanes within a word, the rest pick words, so the cube
+// is one lane pattern ORed into each word its free high bits reach.
+void CPlaFile::addCube( uint64_t careMask, uint64_t valueMask, const char *pOutputs )
+{
+	unsigned int inWordBits = (m_inputCount < 6 ? m_inputCount : 6);
+	uint64_t pattern = m_onSets[0].getLastWordMask();
+	for( unsigned int bit = 0; bit < inWordBits; bit++ ) {
+		if( (careMask >> bit) & 1 )
+			pattern &= ((valueMask >> bit) & 1) ? CTruthTable::getLaneMask( bit ) : ~CTruthTable::getLaneMask( bit );
+	}
+	uint64_t allHigh = (m_inputCount > 6 ? ((uint64_t)1 << (m_inputCount - 6)) - 1 : 0);
+	uint64_t highFree = ~(careMask >> 6) & allHigh;
+	uint64_t highValue = (valueMask >> 6) & allHigh;
+
+	for( int i = 0; i < m_outputCount; i++ )
+	{
+		CTruthTable *pTable;
+		switch( pOutputs[i] )
+		{
+		case '1':
+		case '4':
+			pTable = &m_onSets[i];
+			break;
+		case '-':
+		case '2':
+			pTable = (m_type == PLA_TYPE_FD || m_type == PLA_TYPE_FDR) ? &m_dcSets[i] : 0;
+			break;
+		case '0':
+		case '3':
+			pTable = (m_type == PLA_TYPE_FR || m_type == PLA_TYPE_FDR) ? &m_offSets[i] : 0;
+			break;
+		default:
+			pTable = 0;
+			break;
+		}
+		if( !pTable )
+			continue;
+
+		// Walks every subset of the free high bits
+		std::vector<uint64_t>& words = pTable->getWords();
+		uint64_t subset = 0;
+		do {
+			words[(size_t)(highValue | subset)] |= pattern;
+			subset = (subset - highFree) & highFree;
+		} while( subset != 0 );
+	}
+	m_cubeCount++;
+}
+
+bool CPlaFile::parsePla( const char *pData, size_t size, std::string *pError )
+{
+	const char *pCursor = pData, *pEnd = pData + size, *pLine, *pLineEnd;
+	std::vector<std::string> words;
+	std::string inputPart, outputPart;
+	uint64_t lineNumber = 0;
+	bool allocated = false;
+
+	while( NextLine( &pCursor, pEnd, &pLine, &pLineEnd ) )
+	{
+		lineNumber++;
+		for( const char *p = pLine; p < pLineEnd; p++ ) {
+			if( *p == '#' ) {
+				pLineEnd = p;
+				break;
+			}
+		}
+		while( pLine < pLineEnd && IsBlank( *pLine ) )
+			pLine++;
+		if( pLine == pLineEnd )
+			continue;
+
+		if( *pLine == '.' )
+		{
+			SplitWords( pLine, pLineEnd, &words );
+			const std::string& keyword = words[0];
+			if( keyword == ".e" || keyword == ".end" )
+				break;
+			if( allocated && (keyword == ".i" || keyword == ".o" || keyword == ".type") ) {
+				*pError = LineError( lineNumber, "Header after the first cube" );
+				return false;
+			}
+			if( keyword == ".i" && words.size() > 1 )
+				m_inputCount = atoi( words[1].c_str() );
+			else if( keyword == ".o" && words.size() > 1 )
+				m_outputCount = atoi( words[1].c_str() );
+			else if( keyword == ".ilb" )
+				m_inputNames.assign( words.begin() + 1, words.end() );
+			else if( keyword == ".ob" )
+				m_outputNames.assign( words.begin() + 1, words.end() );
+			else if( keyword == ".type" && words.size() > 1 )
+			{
+				if( words[1] == "f" )
+					m_type = PLA_TYPE_F;
+				else if( words[1] == "fd" )
+					m_type = PLA_TYPE_FD;
+				else if( words[1] == "fr" )
+					m_type = PLA_TYPE_FR;
+				else if( words[1] == "fdr" )
+					m_type = PLA_TYPE_FDR;
+				else {
+					*pError = LineError( lineNumber, "Unsupported .type" );
+					return false;
+				}
+			}
+			// .p and anything else Espresso writes don't change the function
+			continue;
+		}
+
+		// Without .i/.o the first cube's two fields give the widths
+		if( !allocated )
+		{
+			if( m_inputCount == 0 || m_outputCount == 0 ) {
+				SplitWords( pLine, pLineEnd, &words );
+				if( words.size() != 2 || (m_inputCount != 0 && (int)words[0].length() != m_inputCount) ) {
+					*pError = LineError( lineNumber, "Can't tell the inputs from the outputs without .i and .o" );
+					return false;
+				}
+				m_inputCount = (int)words[0].length();
+				m_outputCount = (int)words[1].length();
+			}
+			int inputCount = m_inputCount, outputCount = m_outputCount;
+			if( !this->allocate( inputCount, outputCount, pError ) )
+				return false;
+			allocated = true;
+			outputPart.resize( m_outputCount );
+		}
+
+		// Inputs then outputs, blanks anywhere are only separators
+		uint64_t careMask = 0, valueMask = 0;
+		int inputs = 0, outputs = 0;
+		for( const char *p = pLine; p < pLineEnd; p++ )
+		{
+			if( IsBlank( *p ) )
+				continue;
+			if( inputs < m_inputCount )
+			{
+				uint64_t rowBit = (uint64_t)1 << (m_inputCount - 1 - inputs);
+				switch( *p )
+				{
+				case '1':
+					valueMask |= rowBit;
+					// Falls through
+				case '0':
+					careMask |= rowBit;
+					break;
+				case '-':
+				case '2':
+				case 'x':
+				case 'X':
+					break;
+				default:
+					*pError = LineError( lineNumber, "Invalid input character" );
+					return false;
+				}
+				inputs++;
+			}
+			else if( outputs < m_outputCount )
+				outputPart[outputs++] = *p;
+			else {
+				*pError = LineError( lineNumber, "Too many columns" );
+				return false;
+			}
+		}
+		if( outputs != m_outputCount ) {
+			*pError = LineError( lineNumber, "Too few columns" );
+			return false;
+		}
+		this->addCube( careMask, valueMask, outputPart.c_str() );
+	}
+
+	// Headers but no cubes is a function that is never on
+	if( !allocated && !this->allocate( m_inputCount, m_outputCount, pError ) )
+		return false;
+
+	// With an off set, whatever it and the on set leave out is don't care
+	if( m_type == PLA_TYPE_FR || m_type == PLA_TYPE_FDR )
+	{
+		uint64_t mask = m_onSets[0].getLastWordMask();
+		for( int i = 0; i < m_outputCount; i++ ) {
+			std::vector<uint64_t>& dcWords = m_dcSets[i].getWords();
+			const std::vector<uint64_t>& onWords = m_onSets[i].getWords();
+			const std::vector<uint64_t>& offWords = m_offSets[i].getWords();
+			for( size_t j = 0; j < dcWords.size(); j++ )
+				dcWords[j] |= ~(onWords[j] | offWords[j]) & mask;
+		}
+		m_offSets.clear();
+	}
+
+	return true;
+}
+
+bool CPlaFile::parseRaw( const char *pData, size_t size, std::string *pError )
+{
+	const char *pCursor = pData, *pEnd = pData + size, *pLine, *pLineEnd;
+	uint64_t lineNumber = 0;
+
+	while( NextLine( &pCursor, pEnd, &pLine, &pLineEnd ) )
+	{
+		lineNumber++;
+		while( pLine < pLineEnd && IsBlank( *pLine ) )
+			pLine++;
+		if( pLine == pLineEnd || *pLine == '#' )
+			continue;
+
+		// The first table decides the width
+		uint64_t length = 0;
+		for( const char *p = pLine; p < pLineEnd; p++ ) {
+			if( !IsBlank( *p ) )
+				length++;
+		}
+		if( m_outputCount == 0 )
+		{
+			int inputCount = 0;
+			while( ((uint64_t)1 << inputCount) < length )
+				inputCount++;
+			if( ((uint64_t)1 << inputCount) != length ) {
+				*pError = LineError( lineNumber, "Table length isn't a power of two" );
+				return false;
+			}
+			if( !this->allocate( inputCount, 1, pError ) )
+				return false;
+			m_outputCount = 0;
+		}
+		else if( length != m_onSets[0].getRowCount() ) {
+			*pError = LineError( lineNumber, "Tables have different lengths" );
+			return false;
+		}
+
+		CTruthTable onSet( m_variables ), dcSet( m_variables );
+		std::vector<uint64_t>& onWords = onSet.getWords();
+		std::vector<uint64_t>& dcWords = dcSet.getWords();
+		uint64_t row = 0;
+		for( const char *p = pLine; p < pLineEnd; p++ )
+		{
+			uint64_t bit = (uint64_t)1 << (row & 63);
+			switch( *p )
+			{
+			case ' ':
+			case '\t':
+			case '|':
+				continue;
+			case '1':
+				onWords[(size_t)(row >> 6)] |= bit;
+				break;
+			case '0':
+				break;
+			case '-':
+			case 'x':
+			case 'X':
+				dcWords[(size_t)(row >> 6)] |= bit;
+				break;
+			default:
+				*pError = LineError( lineNumber, "Invalid table character" );
+				return false;
+			}
+			row++;
+		}
+
+		if( m_outputCount < (int)m_onSets.size() ) {
+			m_onSets[m_outputCount] = std::move( onSet );
+			m_dcSets[m_outputCount] = std::move( dcSet );
+		}
+		else {
+			m_onSets.push_back( std::move( onSet ) );
+			m_dcSets.push_back( std::move( dcSet ) );
+		}
+		m_outputCount++;
+		if( (int)m_outputNames.size() < m_outputCount )
+			m_outputNames.push_back( "f" + std::to_string( m_outputCount - 1 ) );
+	}
+
+	if( m_outputCount == 0 ) {
+		*pError = "No tables";
+		return false;
+	}
+	return true;
+}
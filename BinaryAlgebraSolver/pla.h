@@ -0,0 +1,66 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "truthtable.h"
+
+// Inputs become the letters A, B, C... so there can't be more than these
+#define PLA_MAX_INPUTS INPUT_SLOT_COUNT
+// Beyond these the command line only prints counts
+#define PLA_MAX_LIST_INPUTS 16
+#define PLA_MAX_KMAP_INPUTS 6
+// Most memory the on, don't care and off tables of all outputs may take
+#define PLA_MAX_TABLE_BYTES ((uint64_t)256 << 20)
+
+// What the output column of a cube means, as in Espresso's .type
+enum
+{
+	PLA_TYPE_F,
+	PLA_TYPE_FD,
+	PLA_TYPE_FR,
+	PLA_TYPE_FDR
+};
+
+// Loads Espresso style PLA files (.i/.o/.ilb/.ob/.p/.type, cubes with -
+// for don't care inputs, any number of outputs) and raw truth table dumps
+// (one line of 0/1/- per output, 2^n characters long). The file is mapped
+// and walked in place, cubes are expanded straight into the packed on and
+// don't care tables of every output without building per-row strings.
+class CPlaFile
+{
+private:
+	std::vector<char> m_variables;
+	std::vector<std::string> m_inputNames;
+	std::vector<std::string> m_outputNames;
+	std::vector<CTruthTable> m_onSets;
+	std::vector<CTruthTable> m_dcSets;
+	std::vector<CTruthTable> m_offSets;
+	int m_inputCount;
+	int m_outputCount;
+	int m_type;
+	uint64_t m_cubeCount;
+	bool m_raw;
+
+	bool allocate( int inputCount, int outputCount, std::string *pError );
+	void addCube( uint64_t careMask, uint64_t valueMask, const char *pOutputs );
+	bool parsePla( const char *pData, size_t size, std::string *pError );
+	bool parseRaw( const char *pData, size_t size, std::string *pError );
+public:
+	CPlaFile();
+	~CPlaFile();
+
+	bool load( const std::string& path, std::string *pError );
+	bool parse( const char *pData, size_t size, std::string *pError );
+
+	inline int getInputCount() const { return m_inputCount; }
+	inline int getOutputCount() const { return m_outputCount; }
+	inline const std::vector<char>& getVariables() const { return m_variables; }
+	inline const std::string& getInputName( int input ) const { return m_inputNames[input]; }
+	inline const std::string& getOutputName( int output ) const { return m_outputNames[output]; }
+	inline const CTruthTable& getOnSet( int output ) const { return m_onSets[output]; }
+	inline const CTruthTable& getDcSet( int output ) const { return m_dcSets[output]; }
+	inline int getType() const { return m_type; }
+	inline uint64_t getCubeCount() const { return m_cubeCount; }
+	inline bool isRaw() const { return m_raw; }
+};
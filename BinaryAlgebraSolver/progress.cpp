@@ -0,0 +1,116 @@
+#include "progress.h"
+#include <chrono>
+
+static int64_t GetProgressTimeNs() {
+	return (int64_t)std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now().time_since_epoch() ).count();
+}
+
+const char *GetProgressStateName( int state )
+{
+	switch( state )
+	{
+	case PROGRESS_CANCELLED:
+		return "cancelled";
+	case PROGRESS_TIME_LIMIT:
+		return "time limit reached";
+	case PROGRESS_ROW_LIMIT:
+		return "row limit reached";
+	}
+	return "running";
+}
+
+CProgress::CProgress( const char *pLabel, uint64_t totalRows )
+{
+	m_pLabel = pLabel;
+	m_pToken = 0;
+	m_pReportFile = 0;
+	m_totalRows = totalRows;
+	m_rowLimit = 0;
+	m_startNs = GetProgressTimeNs();
+	m_deadlineNs = 0;
+	m_reportIntervalNs = 0;
+	m_rowsDone = 0;
+	m_nextReportNs = 0;
+	m_state = PROGRESS_RUNNING;
+}
+CProgress::~CProgress() {
+}
+
+void CProgress::setCancellationToken( const CCancellationToken *pToken ) {
+	m_pToken = pToken;
+}
+void CProgress::setTimeLimit( double seconds ) {
+	m_deadlineNs = (seconds > 0 ? m_startNs + (int64_t)(seconds * 1e9) : 0);
+}
+void CProgress::setRowLimit( uint64_t rows ) {
+	m_rowLimit = rows;
+}
+void CProgress::setTotalRows( uint64_t rows ) {
+	m_totalRows = rows;
+}
+void CProgress::setReportFile( FILE *pFile, unsigned int intervalMs )
+{
+	m_pReportFile = pFile;
+	m_reportIntervalNs = (int64_t)intervalMs * 1000000;
+	m_nextReportNs = GetProgressTimeNs() + m_reportIntervalNs;
+}
+
+void CProgress::report( uint64_t rowsDone, int64_t nowNs, bool final )
+{
+	double seconds = (nowNs - m_startNs) / 1e9;
+	double rate = (seconds > 0 ? rowsDone / seconds : 0);
+
+	fprintf( m_pReportFile, "%s: %llu", m_pLabel, (unsigned long long)rowsDone );
+	if( m_totalRows > 0 )
+		fprintf( m_pReportFile, " of %llu rows (%.1f%%)", (unsigned long long)m_totalRows, 100.0 * rowsDone / m_totalRows );
+	else
+		fprintf( m_pReportFile, " rows" );
+	fprintf( m_pReportFile, ", %.1fM rows/s", rate / 1e6 );
+	if( final )
+		fprintf( m_pReportFile, ", %.2fs, %s\n", seconds, (this->isStopped() ? GetProgressStateName( this->getState() ) : "done") );
+	else if( m_totalRows > rowsDone && rate > 0 )
+		fprintf( m_pReportFile, ", ETA %.0fs\n", (m_totalRows - rowsDone) / rate );
+	else
+		fprintf( m_pReportFile, "\n" );
+	fflush( m_pReportFile );
+}
+
+bool CProgress::addRows( uint64_t rows )
+{
+	uint64_t rowsDone = m_rowsDone.fetch_add( rows, std::memory_order_relaxed ) + rows;
+	int state = PROGRESS_RUNNING;
+
+	if( this->isStopped() )
+		return false;
+
+	// The clock is only read when something needs it
+	int64_t nowNs = (m_deadlineNs != 0 || m_pReportFile ? GetProgressTimeNs() : 0);
+	if( m_totalRows != 0 && rowsDone >= m_totalRows )
+		state = PROGRESS_RUNNING;
+	else if( m_pToken && m_pToken->isCancelled() )
+		state = PROGRESS_CANCELLED;
+	else if( m_deadlineNs != 0 && nowNs >= m_deadlineNs )
+		state = PROGRESS_TIME_LIMIT;
+	else if( m_rowLimit != 0 && rowsDone >= m_rowLimit )
+		state = PROGRESS_ROW_LIMIT;
+	if( state != PROGRESS_RUNNING ) {
+		int running = PROGRESS_RUNNING;
+		m_state.compare_exchange_strong( running, state );
+		return false;
+	}
+
+	// Whoever moves the report time on gets to print
+	if( m_pReportFile )
+	{
+		int64_t nextReportNs = m_nextReportNs.load( std::memory_order_relaxed );
+		if( nowNs >= nextReportNs && m_nextReportNs.compare_exchange_strong( nextReportNs, nowNs + m_reportIntervalNs ) )
+			this->report( rowsDone, nowNs, false );
+	}
+	return true;
+}
+
+void CProgress::finish()
+{
+	if( m_pReportFile )
+		this->report( this->getRowsDone(), GetProgressTimeNs(), true );
+}
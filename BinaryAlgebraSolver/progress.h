@@ -0,0 +1,72 @@
+#pragma once
+#include <stdint.h>
+#include <stdio.h>
+#include <atomic>
+
+enum
+{
+	PROGRESS_RUNNING,
+	PROGRESS_CANCELLED,
+	PROGRESS_TIME_LIMIT,
+	PROGRESS_ROW_LIMIT
+};
+
+#define PROGRESS_REPORT_INTERVAL_MS 1000
+
+// Set from another thread or a signal handler to stop a long run, the flag
+// is a lock-free atomic so both are safe
+class CCancellationToken
+{
+private:
+	std::atomic<bool> m_cancelled;
+public:
+	CCancellationToken() { m_cancelled = false; }
+
+	inline void cancel() { m_cancelled.store( true, std::memory_order_relaxed ); }
+	inline bool isCancelled() const { return m_cancelled.load( std::memory_order_relaxed ); }
+};
+
+// Limits and progress for a long evaluation. Loops report finished rows
+// through addRows() every chunk of work, from any thread, and stop as soon
+// as it returns false; whatever they finished by then is a valid partial
+// result. Limits that aren't set never stop anything.
+class CProgress
+{
+private:
+	const char *m_pLabel;
+	const CCancellationToken *m_pToken;
+	FILE *m_pReportFile;
+	uint64_t m_totalRows;
+	uint64_t m_rowLimit;
+	int64_t m_startNs;
+	int64_t m_deadlineNs;
+	int64_t m_reportIntervalNs;
+	std::atomic<uint64_t> m_rowsDone;
+	std::atomic<int64_t> m_nextReportNs;
+	std::atomic<int> m_state;
+
+	void report( uint64_t rowsDone, int64_t nowNs, bool final );
+public:
+	CProgress( const char *pLabel, uint64_t totalRows = 0 );
+	~CProgress();
+
+	void setCancellationToken( const CCancellationToken *pToken );
+	void setTimeLimit( double seconds );
+	void setRowLimit( uint64_t rows );
+	void setTotalRows( uint64_t rows );
+	// Periodic "rows done, rows/s, ETA" lines, off until this is called
+	void setReportFile( FILE *pFile, unsigned int intervalMs = PROGRESS_REPORT_INTERVAL_MS );
+
+	// Counts rows and checks the limits, false once the run should stop.
+	// Zero rows just polls, for work that isn't measured in rows. Once the
+	// total is reached there is nothing left to stop, so it keeps running.
+	bool addRows( uint64_t rows );
+	// The last line of the report, says why it stopped if it did
+	void finish();
+
+	inline bool isStopped() const { return m_state.load( std::memory_order_relaxed ) != PROGRESS_RUNNING; }
+	inline int getState() const { return m_state.load( std::memory_order_relaxed ); }
+	inline uint64_t getRowsDone() const { return m_rowsDone.load( std::memory_order_relaxed ); }
+};
+
+const char *GetProgressStateName( int state );
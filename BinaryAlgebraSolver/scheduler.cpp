@@ -0,0 +1,168 @@
+#include "scheduler.h"
+
+// The worker the current thread belongs to, if any
+static thread_local CTaskScheduler *t_pScheduler = 0;
+static thread_local unsigned int t_workerIndex = 0;
+
+CTaskScheduler::CTaskScheduler( unsigned int threadCount )
+{
+	m_queuedTasks = 0;
+	m_pendingTasks = 0;
+	m_nextQueue = 0;
+	m_shutdown = false;
+
+	if( threadCount == 0 )
+		threadCount = std::thread::hardware_concurrency();
+	if( threadCount == 0 )
+		threadCount = 1;
+
+	for( unsigned int i = 0; i < threadCount; i++ )
+		m_queues.push_back( std::unique_ptr<WorkerQueue>( new WorkerQueue() ) );
+	for( unsigned int i = 0; i < threadCount; i++ )
+		m_workers.push_back( std::thread( &CTaskScheduler::workerMain, this, i ) );
+}
+CTaskScheduler::~CTaskScheduler()
+{
+	{
+		std::lock_guard<std::mutex> lock( m_wakeLock );
+		m_shutdown = true;
+	}
+	m_wakeCondition.notify_all();
+	for( auto it = m_workers.begin(); it != m_workers.end(); it++ )
+		(*it).join();
+}
+
+void CTaskScheduler::submit( std::function<void()> task )
+{
+	unsigned int queue;
+
+	// Workers keep their own children, everyone else spreads them out
+	if( t_pScheduler == this )
+		queue = t_workerIndex;
+	else
+		queue = m_nextQueue++ % m_queues.size();
+
+	m_pendingTasks++;
+	{
+		std::lock_guard<std::mutex> lock( m_queues[queue]->lock );
+		m_queues[queue]->tasks.push_back( task );
+	}
+	{
+		std::lock_guard<std::mutex> lock( m_wakeLock );
+		m_queuedTasks++;
+	}
+	m_wakeCondition.notify_one();
+}
+
+void CTaskScheduler::submit( CTaskGroup& group, std::function<void()> task )
+{
+	CTaskGroup *pGroup = &group;
+
+	group.m_pendingTasks++;
+	this->submit( [this, pGroup, task]() {
+		task();
+		// The waiter may free the group as soon as it sees zero
+		if( --pGroup->m_pendingTasks == 0 ) {
+			std::lock_guard<std::mutex> lock( m_wakeLock );
+			m_idleCondition.notify_all();
+			m_wakeCondition.notify_all();
+		}
+	} );
+}
+
+void CTaskScheduler::wait()
+{
+	std::unique_lock<std::mutex> lock( m_wakeLock );
+	m_idleCondition.wait( lock, [this]()->bool {
+		return m_pendingTasks == 0;
+	} );
+}
+
+void CTaskScheduler::wait( CTaskGroup& group )
+{
+	// Outside the pool there is nothing to help with, just sleep
+	if( t_pScheduler != this ) {
+		std::unique_lock<std::mutex> lock( m_wakeLock );
+		m_idleCondition.wait( lock, [&group]()->bool {
+			return group.m_pendingTasks == 0;
+		} );
+		return;
+	}
+
+	// A worker runs whatever it can get until the group is done, which
+	// is usually the group's own pieces since they sit on top of its deque
+	std::function<void()> task;
+	while( group.m_pendingTasks != 0 )
+	{
+		if( this->popTask( t_workerIndex, &task ) ) {
+			this->runTask( task );
+			continue;
+		}
+		std::unique_lock<std::mutex> lock( m_wakeLock );
+		m_wakeCondition.wait( lock, [this, &group]()->bool {
+			return group.m_pendingTasks == 0 || m_queuedTasks > 0;
+		} );
+	}
+}
+
+bool CTaskScheduler::popTask( unsigned int worker, std::function<void()> *pTask )
+{
+	// Newest of our own first
+	{
+		WorkerQueue& own = *m_queues[worker];
+		std::lock_guard<std::mutex> lock( own.lock );
+		if( !own.tasks.empty() ) {
+			*pTask = std::move( own.tasks.back() );
+			own.tasks.pop_back();
+			m_queuedTasks--;
+			return true;
+		}
+	}
+	// Then the oldest of someone else's
+	for( unsigned int i = 1; i < m_queues.size(); i++ )
+	{
+		WorkerQueue& victim = *m_queues[(worker + i) % m_queues.size()];
+		std::lock_guard<std::mutex> lock( victim.lock );
+		if( !victim.tasks.empty() ) {
+			*pTask = std::move( victim.tasks.front() );
+			victim.tasks.pop_front();
+			m_queuedTasks--;
+			return true;
+		}
+	}
+	return false;
+}
+
+void CTaskScheduler::runTask( std::function<void()>& task )
+{
+	task();
+	task = nullptr;
+	if( --m_pendingTasks == 0 ) {
+		std::lock_guard<std::mutex> lock( m_wakeLock );
+		m_idleCondition.notify_all();
+	}
+}
+
+void CTaskScheduler::workerMain( unsigned int worker )
+{
+	std::function<void()> task;
+
+	t_pScheduler = this;
+	t_workerIndex = worker;
+
+	while( true )
+	{
+		if( this->popTask( worker, &task ) ) {
+			this->runTask( task );
+			continue;
+		}
+
+		// Nothing to run or steal, sleep until something is submitted
+		std::unique_lock<std::mutex> lock( m_wakeLock );
+		m_wakeCondition.wait( lock, [this]()->bool {
+			return m_shutdown || m_queuedTasks > 0;
+		} );
+		if( m_shutdown && m_queuedTasks == 0 )
+			break;
+	}
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Tasks that are waited on together. Tasks can split their own work into
+// a group and wait on it, a worker waiting on a group keeps running other
+// tasks so nothing blocks while pieces are still queued.
+class CTaskGroup
+{
+private:
+	friend class CTaskScheduler;
+	std::atomic<int> m_pendingTasks;
+public:
+	CTaskGroup() { m_pendingTasks = 0; }
+
+	inline bool isDone() const { return m_pendingTasks == 0; }
+};
+
+// Work stealing thread pool. Every worker owns a deque, runs its own work
+// newest first and steals the oldest work of the others when it runs dry.
+// Tasks submitted from a worker go to that worker's own deque.
+class CTaskScheduler
+{
+private:
+	struct WorkerQueue
+	{
+		std::mutex lock;
+		std::deque<std::function<void()>> tasks;
+	};
+
+	std::vector<std::thread> m_workers;
+	std::vector<std::unique_ptr<WorkerQueue>> m_queues;
+
+	std::mutex m_wakeLock;
+	std::condition_variable m_wakeCondition;
+	std::condition_variable m_idleCondition;
+	std::atomic<int> m_queuedTasks;
+	std::atomic<int> m_pendingTasks;
+	std::atomic<unsigned int> m_nextQueue;
+	bool m_shutdown;
+
+	bool popTask( unsigned int worker, std::function<void()> *pTask );
+	void runTask( std::function<void()>& task );
+	void workerMain( unsigned int worker );
+public:
+	CTaskScheduler( unsigned int threadCount = 0 );
+	~CTaskScheduler();
+
+	void submit( std::function<void()> task );
+	void submit( CTaskGroup& group, std::function<void()> task );
+	// Everything submitted so far, only for threads outside the pool
+	void wait();
+	// Just the group, from anywhere
+	void wait( CTaskGroup& group );
+
+	inline unsigned int getThreadCount() const { return (unsigned int)m_workers.size(); }
+};
@@ -0,0 +1,602 @@
+#include "server.h"
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include "anf.h"
+#include "equivalence.h"
+#include "karnaughmap.h"
+#include "util.h"
+#ifndef _WIN32
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+CSolverServer::ClientConnection::ClientConnection( int socket, FILE *pOutput ) {
+	this->socket = socket;
+	this->pOutput = pOutput;
+}
+CSolverServer::ClientConnection::~ClientConnection()
+{
+#ifndef _WIN32
+	if( socket != -1 )
+		close( socket );
+#endif
+}
+void CSolverServer::ClientConnection::write( const std::string& line )
+{
+	std::lock_guard<std::mutex> lock( writeLock );
+	if( pOutput ) {
+		fputs( line.c_str(), pOutput );
+		fputc( '\n', pOutput );
+		fflush( pOutput );
+		return;
+	}
+#ifndef _WIN32
+	std::string data = line + "\n";
+	size_t written = 0;
+	while( written < data.length() ) {
+		ssize_t result = ::write( socket, data.c_str() + written, data.length() - written );
+		if( result <= 0 )
+			return;
+		written += result;
+	}
+#endif
+}
+
+CSolverServer::CSolverServer( unsigned int threadCount ) : m_jobs( SERVER_QUEUE_CAPACITY )
+{
+	m_clientCount = 0;
+	m_shutdown = false;
+	m_listenSocket = -1;
+	m_wakePipe[0] = -1;
+	m_wakePipe[1] = -1;
+	m_requestCount = 0;
+	m_errorCount = 0;
+	m_totalLatency = 0;
+	m_maxLatency = 0;
+
+	if( threadCount == 0 )
+		threadCount = std::thread::hardware_concurrency();
+	if( threadCount == 0 )
+		threadCount = 1;
+	for( unsigned int i = 0; i < threadCount; i++ )
+		m_workers.push_back( std::thread( &CSolverServer::workerMain, this ) );
+}
+CSolverServer::~CSolverServer()
+{
+	m_jobs.close();
+	for( auto it = m_workers.begin(); it != m_workers.end(); it++ )
+		(*it).join();
+}
+
+bool CSolverServer::getEquation( const std::string& equation, std::shared_ptr<const CachedEquation> *pEquation, std::string *pError )
+{
+	{
+		std::lock_guard<std::mutex> lock( m_cacheLock );
+		auto it = m_cache.find( equation );
+		if( it != m_cache.end() ) {
+			*pEquation = (*it).second;
+			return true;
+		}
+	}
+
+	// Build outside the lock, the entry is immutable once it's shared
+	std::shared_ptr<CachedEquation> pEntry( new CachedEquation() );
+	int parseError;
+	if( !pEntry->parser.parse( equation, &parseError ) || !pEntry->graph.addEquation( pEntry->parser, &parseError ) ) {
+		*pError = (parseError == PARSE_ERROR_INVALID_LITERAL ? "Invalid literal in equation" : "Invalid equation");
+		return false;
+	}
+	pEntry->hasTable = (pEntry->graph.getUniqueVariableCount() <= SERVER_MAX_TABLE_VARIABLES);
+	if( pEntry->hasTable ) {
+		std::vector<CTruthTable> tables;
+		pEntry->graph.evaluateTables( &tables );
+		pEntry->table = tables[0];
+	}
+
+	std::lock_guard<std::mutex> lock( m_cacheLock );
+	if( m_cache.find( equation ) == m_cache.end() )
+	{
+		// Oldest entry goes first
+		if( m_cacheOrder.size() >= SERVER_CACHE_SIZE ) {
+			m_cache.erase( m_cacheOrder.front() );
+			m_cacheOrder.pop_front();
+		}
+		m_cache[equation] = pEntry;
+		m_cacheOrder.push_back( equation );
+	}
+	*pEquation = pEntry;
+	return true;
+}
+
+bool CSolverServer::handleRequest( const std::map<std::string, std::string>& request, CJsonWriter *pResponse, std::string *pError )
+{
+	std::shared_ptr<const CachedEquation> pEquation;
+	std::string op, equation;
+
+	auto it = request.find( "op" );
+	if( it == request.end() ) {
+		*pError = "Missing op";
+		return false;
+	}
+	op = (*it).second;
+
+	if( op == "stats" )
+	{
+		uint64_t requestCount = m_requestCount;
+		pResponse->addNumber( "requests", (int64_t)requestCount );
+		pResponse->addNumber( "errors", (int64_t)m_errorCount );
+		pResponse->addNumber( "mean_latency_us", (requestCount > 0 ? (double)m_totalLatency / requestCount : 0.0) );
+		pResponse->addNumber( "max_latency_us", (int64_t)m_maxLatency );
+		pResponse->addNumber( "queue_depth", (int64_t)m_jobs.size() );
+		pResponse->addNumber( "clients", (int64_t)m_clientCount );
+		std::lock_guard<std::mutex> lock( m_cacheLock );
+		pResponse->addNumber( "cached_equations", (int64_t)m_cache.size() );
+		return true;
+	}
+	if( op == "shutdown" ) {
+		this->requestShutdown();
+		return true;
+	}
+
+	// Everything else works on an equation
+	it = request.find( "equation" );
+	if( it == request.end() ) {
+		*pError = "Missing equation";
+		return false;
+	}
+	if( !this->getEquation( (*it).second, &pEquation, pError ) )
+		return false;
+	const std::vector<char>& variables = pEquation->graph.getUniqueVariables();
+	pResponse->addString( "equation", pEquation->parser.getCleanEquation() );
+	pResponse->addString( "variables", std::string( variables.begin(), variables.end() ) );
+
+	if( op == "parse" ) {
+		pResponse->addNumber( "nodes", (int64_t)pEquation->graph.getNodeCount() );
+		return true;
+	}
+	if( op == "compare" )
+	{
+		std::shared_ptr<const CachedEquation> pComparison;
+		EquivalenceResult result;
+
+		it = request.find( "comparison" );
+		if( it == request.end() ) {
+			*pError = "Missing comparison";
+			return false;
+		}
+		if( !this->getEquation( (*it).second, &pComparison, pError ) )
+			return false;
+
+		CheckEquivalence( pEquation->graph, 0, pComparison->graph, 0, &result );
+		pResponse->addBool( "equal", result.equal );
+		if( !result.equal )
+		{
+			// The counterexample is over the inputs of both equations
+			std::vector<char> allVariables = variables;
+			const std::vector<char>& comparisonVariables = pComparison->graph.getUniqueVariables();
+			for( auto var = comparisonVariables.begin(); var != comparisonVariables.end(); var++ ) {
+				if( std::find( allVariables.begin(), allVariables.end(), (*var) ) == allVariables.end() )
+					allVariables.push_back( (*var) );
+			}
+			std::sort( allVariables.begin(), allVariables.end() );
+			pResponse->addString( "counterexample_variables", std::string( allVariables.begin(), allVariables.end() ) );
+			pResponse->addString( "counterexample", ConvertIntToBinary( (int)result.counterexample, (unsigned int)allVariables.size() ) );
+		}
+		pResponse->addNumber( "rows_checked", (int64_t)result.rowsChecked );
+		return true;
+	}
+
+	// The rest need the whole table
+	if( !pEquation->hasTable ) {
+		*pError = "Too many variables for a full table";
+		return false;
+	}
+	if( op == "truthtable" )
+	{
+		std::string table;
+		table.reserve( (size_t)pEquation->table.getRowCount() );
+		for( uint64_t i = 0; i < pEquation->table.getRowCount(); i++ )
+			table.push_back( pEquation->table.get( i ) ? '1' : '0' );
+		pResponse->addString( "table", table );
+		return true;
+	}
+	if( op == "anf" )
+	{
+		CTruthTable anf;
+		ComputeAnf( pEquation->table, &anf );
+		uint64_t termCount = anf.countOnes();
+		if( termCount <= ANF_MAX_FORMAT_TERMS )
+			pResponse->addString( "anf", FormatAnf( anf ) );
+		pResponse->addNumber( "terms", (int64_t)termCount );
+		pResponse->addNumber( "degree", (int64_t)GetAnfDegree( anf ) );
+		return true;
+	}
+	if( op == "minterms" || op == "kmap" )
+	{
+		std::vector<int> donkeyTerms, allMinterms, allMaxterms, minterms, maxterms;
+
+		it = request.find( "donkeys" );
+		if( it != request.end() )
+			donkeyTerms = ParseDonkeys( (*it).second );
+		pEquation->table.getMinterms( &allMinterms );
+		pEquation->table.getMaxterms( &allMaxterms );
+		for( auto term = allMinterms.begin(); term != allMinterms.end(); term++ ) {
+			if( std::find( donkeyTerms.begin(), donkeyTerms.end(), (*term) ) == donkeyTerms.end() )
+				minterms.push_back( (*term) );
+		}
+		for( auto term = allMaxterms.begin(); term != allMaxterms.end(); term++ ) {
+			if( std::find( donkeyTerms.begin(), donkeyTerms.end(), (*term) ) == donkeyTerms.end() )
+				maxterms.push_back( (*term) );
+		}
+
+		if( op == "minterms" ) {
+			pResponse->addIntArray( "minterms", minterms );
+			pResponse->addIntArray( "maxterms", maxterms );
+			pResponse->addIntArray( "donkeys", donkeyTerms );
+			return true;
+		}
+
+		if( variables.size() > SERVER_MAX_KMAP_VARIABLES ) {
+			*pError = "Too many variables for a K-Map";
+			return false;
+		}
+
+		CKarnaughMap kmap;
+		std::string columns, rows, kmapText;
+		kmap.m_uniqueVariables = variables;
+		kmap.m_minTerms = minterms;
+		kmap.m_maxTerms = maxterms;
+		kmap.m_donkeyTerms = donkeyTerms;
+
+		it = request.find( "columns" );
+		if( it != request.end() )
+			columns = (*it).second;
+		it = request.find( "rows" );
+		if( it != request.end() )
+			rows = (*it).second;
+		if( !kmap.setColumnVars( columns ) || !kmap.setRowVars( rows ) ) {
+			*pError = "Invalid K-Map columns or rows";
+			return false;
+		}
+		it = request.find( "control" );
+		if( it != request.end() && (*it).second == "r" )
+			kmap.m_controlSignals = CONTROL_SIGNALS_ROW;
+		else if( it != request.end() && (*it).second == "c" )
+			kmap.m_controlSignals = CONTROL_SIGNALS_COLUMN;
+
+		kmap.format( &kmapText );
+		pResponse->addString( "kmap", kmapText );
+		return true;
+	}
+
+	*pError = "Unknown op " + op;
+	return false;
+}
+
+// Echoes the id back as it came in so clients can match out of order
+// responses, bare values were already checked to be valid JSON
+static void AddRequestId( const std::map<std::string, std::string>& request, const std::set<std::string>& quoted, CJsonWriter *pResponse )
+{
+	auto it = request.find( "id" );
+	if( it == request.end() )
+		return;
+	if( quoted.count( "id" ) )
+		pResponse->addString( "id", (*it).second );
+	else
+		pResponse->addRaw( "id", (*it).second );
+}
+
+std::string CSolverServer::processJob( const ServerJob& job )
+{
+	std::map<std::string, std::string> request;
+	std::set<std::string> quoted;
+	CJsonWriter response;
+	std::string error;
+	bool ok;
+
+	if( !ParseJsonObject( job.line, &request, &quoted ) ) {
+		ok = false;
+		error = "Malformed request";
+	}
+	else {
+		AddRequestId( request, quoted, &response );
+		ok = this->handleRequest( request, &response, &error );
+	}
+
+	response.addBool( "ok", ok );
+	if( !ok ) {
+		response.addString( "error", error );
+		m_errorCount++;
+	}
+
+	// Latency includes the time spent queued
+	uint64_t latency = (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>( std::chrono::steady_clock::now() - job.received ).count();
+	response.addNumber( "latency_us", (int64_t)latency );
+	m_requestCount++;
+	m_totalLatency += latency;
+	uint64_t maxLatency = m_maxLatency;
+	while( latency > maxLatency && !m_maxLatency.compare_exchange_weak( maxLatency, latency ) )
+		;
+
+	return response.finish();
+}
+
+// The response for a request that is never run
+std::string CSolverServer::rejectLine( const std::string& line, const std::string& error )
+{
+	std::map<std::string, std::string> request;
+	std::set<std::string> quoted;
+	CJsonWriter response;
+
+	if( ParseJsonObject( line, &request, &quoted ) )
+		AddRequestId( request, quoted, &response );
+	response.addBool( "ok", false );
+	response.addString( "error", error );
+	m_requestCount++;
+	m_errorCount++;
+	return response.finish();
+}
+
+// Queues a request line, or turns it away once shutdown has been asked for
+void CSolverServer::submitLine( std::shared_ptr<ClientConnection> pClient, const std::string& line )
+{
+	ServerJob job;
+
+	if( line == "" )
+		return;
+	job.pClient = pClient;
+	job.line = line;
+	job.received = std::chrono::steady_clock::now();
+	if( m_shutdown || !m_jobs.push( job ) )
+		pClient->write( this->rejectLine( line, "Server is shutting down" ) );
+}
+
+std::string CSolverServer::processLine( const std::string& line )
+{
+	ServerJob job;
+	job.line = line;
+	job.received = std::chrono::steady_clock::now();
+	return this->processJob( job );
+}
+
+void CSolverServer::workerMain()
+{
+	ServerJob job;
+	while( m_jobs.pop( &job ) ) {
+		job.pClient->write( this->processJob( job ) );
+		job.pClient.reset();
+	}
+}
+
+void CSolverServer::requestShutdown()
+{
+	m_shutdown = true;
+#ifndef _WIN32
+	if( m_wakePipe[1] != -1 ) {
+		char wake = 0;
+		if( ::write( m_wakePipe[1], &wake, 1 ) != 1 )
+			fprintf( stderr, "ERROR: Could not wake the input reader\n" );
+	}
+	// Unblocks accept() and every client read
+	if( m_listenSocket != -1 )
+		shutdown( m_listenSocket, SHUT_RDWR );
+	std::lock_guard<std::mutex> lock( m_clientLock );
+	for( auto it = m_clients.begin(); it != m_clients.end(); it++ )
+		shutdown( (*it)->socket, SHUT_RD );
+#endif
+}
+
+int CSolverServer::serveStream( FILE *pInput, FILE *pOutput )
+{
+	std::shared_ptr<ClientConnection> pClient( new ClientConnection( -1, pOutput ) );
+	std::string pending;
+
+#ifdef _WIN32
+	std::vector<char> buffer( 4096 );
+	while( !m_shutdown && fgets( &buffer[0], (int)buffer.size(), pInput ) )
+	{
+		pending += &buffer[0];
+		if( pending[pending.length() - 1] != '\n' && !feof( pInput ) )
+			continue;
+		while( !pending.empty() && (pending[pending.length() - 1] == '\n' || pending[pending.length() - 1] == '\r') )
+			pending.erase( pending.length() - 1 );
+		this->submitLine( pClient, pending );
+		pending.clear();
+	}
+#else
+	// Reads the descriptor rather than through stdio so a shutdown request
+	// can interrupt the wait through the wake pipe
+	char buffer[4096];
+	pollfd fds[2];
+
+	if( pipe( m_wakePipe ) != 0 ) {
+		fprintf( stderr, "ERROR: Could not create the wake pipe\n" );
+		m_wakePipe[0] = -1;
+		m_wakePipe[1] = -1;
+		return 10;
+	}
+	fds[0].fd = fileno( pInput );
+	fds[0].events = POLLIN;
+	fds[1].fd = m_wakePipe[0];
+	fds[1].events = POLLIN;
+
+	while( !m_shutdown )
+	{
+		if( poll( fds, 2, -1 ) < 0 ) {
+			if( errno == EINTR )
+				continue;
+			break;
+		}
+		if( fds[1].revents != 0 )
+			break;
+		ssize_t received = read( fds[0].fd, buffer, sizeof( buffer ) );
+		if( received <= 0 )
+			break;
+		pending.append( buffer, received );
+
+		// Lines after a shutdown in the same read are answered with an error
+		size_t pos;
+		while( (pos = pending.find( '\n' )) != std::string::npos )
+		{
+			std::string line = pending.substr( 0, pos );
+			pending.erase( 0, pos + 1 );
+			if( !line.empty() && line[line.length() - 1] == '\r' )
+				line.erase( line.length() - 1 );
+			this->submitLine( pClient, line );
+		}
+	}
+	// A last line without a newline
+	while( !pending.empty() && pending[pending.length() - 1] == '\r' )
+		pending.erase( pending.length() - 1 );
+	this->submitLine( pClient, pending );
+#endif
+
+	// Let the workers drain what's left
+	m_jobs.close();
+	for( auto it = m_workers.begin(); it != m_workers.end(); it++ )
+		(*it).join();
+	m_workers.clear();
+#ifndef _WIN32
+	close( m_wakePipe[0] );
+	close( m_wakePipe[1] );
+	m_wakePipe[0] = -1;
+	m_wakePipe[1] = -1;
+#endif
+
+	return 0;
+}
+
+void CSolverServer::clientMain( std::shared_ptr<ClientConnection> pClient, std::shared_ptr<std::atomic<bool>> pFinished )
+{
+#ifndef _WIN32
+	char buffer[4096];
+	std::string pending;
+	ssize_t received;
+
+	while( (received = read( pClient->socket, buffer, sizeof( buffer ) )) > 0 )
+	{
+		pending.append( buffer, received );
+		size_t pos;
+		while( (pos = pending.find( '\n' )) != std::string::npos )
+		{
+			std::string line = pending.substr( 0, pos );
+			pending.erase( 0, pos + 1 );
+			if( !line.empty() && line[line.length() - 1] == '\r' )
+				line.erase( line.length() - 1 );
+			// Blocks while the queue is full, so a busy server stops reading
+			this->submitLine( pClient, line );
+		}
+	}
+#endif
+	{
+		std::lock_guard<std::mutex> lock( m_clientLock );
+		m_clients.erase( std::remove( m_clients.begin(), m_clients.end(), pClient ), m_clients.end() );
+	}
+	m_clientCount--;
+	*pFinished = true;
+}
+
+int CSolverServer::serveSocket( const std::string& path )
+{
+#ifdef _WIN32
+	fprintf( stderr, "ERROR: Socket mode is not supported on this platform, use stdin/stdout\n" );
+	return 10;
+#else
+	sockaddr_un address;
+	int result = 0;
+
+	// A client hanging up shouldn't take the server with it
+	signal( SIGPIPE, SIG_IGN );
+
+	if( path.length() >= sizeof( address.sun_path ) ) {
+		fprintf( stderr, "ERROR: Socket path too long\n" );
+		return 10;
+	}
+	m_listenSocket = socket( AF_UNIX, SOCK_STREAM, 0 );
+	if( m_listenSocket == -1 ) {
+		fprintf( stderr, "ERROR: Could not create socket\n" );
+		return 10;
+	}
+	memset( &address, 0, sizeof( address ) );
+	address.sun_family = AF_UNIX;
+	strncpy( address.sun_path, path.c_str(), sizeof( address.sun_path ) - 1 );
+	unlink( path.c_str() );
+	if( bind( m_listenSocket, (sockaddr*)&address, sizeof( address ) ) != 0 || listen( m_listenSocket, SERVER_MAX_CLIENTS ) != 0 ) {
+		fprintf( stderr, "ERROR: Could not listen on %s\n", path.c_str() );
+		close( m_listenSocket );
+		m_listenSocket = -1;
+		return 10;
+	}
+	fprintf( stderr, "Listening on %s\n", path.c_str() );
+
+	while( !m_shutdown )
+	{
+		int client = accept( m_listenSocket, 0, 0 );
+		if( client == -1 )
+		{
+			if( m_shutdown || errno == EINTR || errno == ECONNABORTED )
+				continue;
+			// Out of descriptors or memory can pass once clients hang up
+			if( errno == EMFILE || errno == ENFILE || errno == ENOBUFS || errno == ENOMEM ) {
+				std::this_thread::sleep_for( std::chrono::milliseconds( SERVER_ACCEPT_BACKOFF_MS ) );
+				continue;
+			}
+			fprintf( stderr, "ERROR: Could not accept connections (%s)\n", strerror( errno ) );
+			this->requestShutdown();
+			result = 10;
+			break;
+		}
+
+		std::shared_ptr<ClientConnection> pClient( new ClientConnection( client, 0 ) );
+		if( m_clientCount >= SERVER_MAX_CLIENTS ) {
+			pClient->write( "{\"ok\":false,\"error\":\"Too many clients\"}" );
+			continue;
+		}
+		m_clientCount++;
+
+		// Reap the readers of clients that already hung up
+		for( auto it = m_clientThreads.begin(); it != m_clientThreads.end(); ) {
+			if( *(*it).pFinished ) {
+				(*it).thread.join();
+				it = m_clientThreads.erase( it );
+			}
+			else
+				it++;
+		}
+
+		ClientThread clientThread;
+		clientThread.pFinished = std::make_shared<std::atomic<bool>>( false );
+		{
+			std::lock_guard<std::mutex> lock( m_clientLock );
+			m_clients.push_back( pClient );
+		}
+		clientThread.thread = std::thread( &CSolverServer::clientMain, this, pClient, clientThread.pFinished );
+		m_clientThreads.push_back( std::move( clientThread ) );
+	}
+
+	for( auto it = m_clientThreads.begin(); it != m_clientThreads.end(); it++ )
+		(*it).thread.join();
+	m_clientThreads.clear();
+	m_jobs.close();
+	for( auto it = m_workers.begin(); it != m_workers.end(); it++ )
+		(*it).join();
+	m_workers.clear();
+
+	close( m_listenSocket );
+	m_listenSocket = -1;
+	unlink( path.c_str() );
+	return result;
+#endif
+}
+
+void CSolverServer::printSummary( FILE *pFile )
+{
+	uint64_t requestCount = m_requestCount;
+	fprintf( pFile, "Served %llu requests (%llu errors), mean latency %.1f us, max %llu us\n", (unsigned long long)requestCount,
+		(unsigned long long)m_errorCount, (requestCount > 0 ? (double)m_totalLatency / requestCount : 0.0), (unsigned long long)m_maxLatency );
+}
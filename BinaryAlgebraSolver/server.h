@@ -0,0 +1,107 @@
+#pragma once
+#include <stdint.h>
+#include <stdio.h>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "boundedqueue.h"
+#include "equationparser.h"
+#include "expressiongraph.h"
+#include "jsonline.h"
+#include "truthtable.h"
+
+// Requests waiting for a worker before readers block
+#define SERVER_QUEUE_CAPACITY 256
+#define SERVER_MAX_CLIENTS 64
+// Parsed equations kept warm between requests
+#define SERVER_CACHE_SIZE 1024
+// Largest function the server will send a whole table for
+#define SERVER_MAX_TABLE_VARIABLES 20
+// K-Maps are formatted cell by cell, keep them to what fits on a screen
+#define SERVER_MAX_KMAP_VARIABLES 6
+// Pause before accept() is retried after running out of descriptors
+#define SERVER_ACCEPT_BACKOFF_MS 100
+
+struct CachedEquation
+{
+	CEquationParser parser;
+	CExpressionGraph graph;
+	CTruthTable table;
+	bool hasTable;
+};
+
+// Long running solver answering JSON lines requests, either on stdin/stdout
+// or on a Unix domain socket. Each line is one request object such as
+//   {"id":1,"op":"minterms","equation":"AB+C","donkeys":"0,2"}
+// and gets exactly one response line carrying the same id. Operations are
+// parse, truthtable, minterms, anf, compare, kmap, stats and shutdown.
+class CSolverServer
+{
+private:
+	struct ClientConnection
+	{
+		int socket;
+		FILE *pOutput;
+		std::mutex writeLock;
+
+		ClientConnection( int socket, FILE *pOutput );
+		~ClientConnection();
+		void write( const std::string& line );
+	};
+	struct ClientThread
+	{
+		std::shared_ptr<std::atomic<bool>> pFinished;
+		std::thread thread;
+	};
+	struct ServerJob
+	{
+		std::shared_ptr<ClientConnection> pClient;
+		std::string line;
+		std::chrono::steady_clock::time_point received;
+	};
+
+	CBoundedQueue<ServerJob> m_jobs;
+	std::vector<std::thread> m_workers;
+
+	std::mutex m_cacheLock;
+	std::map<std::string, std::shared_ptr<const CachedEquation>> m_cache;
+	std::deque<std::string> m_cacheOrder;
+
+	std::mutex m_clientLock;
+	std::vector<std::shared_ptr<ClientConnection>> m_clients;
+	std::vector<ClientThread> m_clientThreads;
+	std::atomic<int> m_clientCount;
+	std::atomic<bool> m_shutdown;
+	int m_listenSocket;
+	// Written to on shutdown so serveStream stops waiting for input
+	int m_wakePipe[2];
+
+	std::atomic<uint64_t> m_requestCount;
+	std::atomic<uint64_t> m_errorCount;
+	std::atomic<uint64_t> m_totalLatency;
+	std::atomic<uint64_t> m_maxLatency;
+
+	bool getEquation( const std::string& equation, std::shared_ptr<const CachedEquation> *pEquation, std::string *pError );
+	bool handleRequest( const std::map<std::string, std::string>& request, CJsonWriter *pResponse, std::string *pError );
+	std::string processJob( const ServerJob& job );
+	std::string rejectLine( const std::string& line, const std::string& error );
+	void submitLine( std::shared_ptr<ClientConnection> pClient, const std::string& line );
+	void workerMain();
+	void clientMain( std::shared_ptr<ClientConnection> pClient, std::shared_ptr<std::atomic<bool>> pFinished );
+	void requestShutdown();
+public:
+	CSolverServer( unsigned int threadCount );
+	~CSolverServer();
+
+	std::string processLine( const std::string& line );
+
+	int serveStream( FILE *pInput, FILE *pOutput );
+	int serveSocket( const std::string& path );
+	void printSummary( FILE *pFile );
+};
@@ -0,0 +1,245 @@
+#include "shortcircuit.h"
+#include <algorithm>
+#include "stats.h"
+
+CShortCircuitProgram::CShortCircuitProgram() {
+	m_root = -1;
+	m_compiled = false;
+}
+CShortCircuitProgram::~CShortCircuitProgram() {
+}
+
+// Collects the operands of a chain of the same operator, so a*b*c becomes
+// one AND with three operands instead of two nested ones
+void CShortCircuitProgram::gatherOperands( const CExpressionGraph& graph, int node, unsigned char nodeType, std::vector<int> *pOperands ) const
+{
+	const ExpressionNode& expression = graph.getNode( node );
+	if( pOperands->size() > SHORT_CIRCUIT_MAX_NODES )
+		return;
+	if( expression.nodeType != nodeType ) {
+		pOperands->push_back( node );
+		return;
+	}
+	this->gatherOperands( graph, expression.left, nodeType, pOperands );
+	this->gatherOperands( graph, expression.right, nodeType, pOperands );
+}
+
+// Returns the tree node for a graph node, or -1 once the tree is too big
+int CShortCircuitProgram::expand( const CExpressionGraph& graph, int node, const unsigned char *pShifts )
+{
+	const ExpressionNode& expression = graph.getNode( node );
+	TreeNode tree;
+
+	if( expression.nodeType == NODE_TYPE_NOT ) {
+		int operand = this->expand( graph, expression.left, pShifts );
+		if( operand != -1 )
+			m_nodes[operand].negated = !m_nodes[operand].negated;
+		return operand;
+	}
+
+	tree.op = expression.nodeType;
+	tree.negated = false;
+	tree.shift = 0;
+	tree.trueCount = 0;
+	if( expression.nodeType == NODE_TYPE_VARIABLE )
+		tree.shift = pShifts[expression.variable - 'A'];
+	else if( expression.nodeType == NODE_TYPE_AND || expression.nodeType == NODE_TYPE_OR || expression.nodeType == NODE_TYPE_XOR )
+	{
+		std::vector<int> operands;
+		this->gatherOperands( graph, node, expression.nodeType, &operands );
+		if( operands.size() > SHORT_CIRCUIT_MAX_NODES )
+			return -1;
+		for( unsigned int i = 0; i < operands.size(); i++ ) {
+			int operand = this->expand( graph, operands[i], pShifts );
+			if( operand == -1 )
+				return -1;
+			tree.operands.push_back( operand );
+		}
+	}
+
+	if( m_nodes.size() >= SHORT_CIRCUIT_MAX_NODES )
+		return -1;
+	m_nodes.push_back( tree );
+	return (int)m_nodes.size() - 1;
+}
+
+// Lays a subtree out in prefix order and fills in where it ends
+void CShortCircuitProgram::emit( int node )
+{
+	const TreeNode& tree = m_nodes[node];
+	ShortCircuitInstruction instruction;
+	uint32_t pc = (uint32_t)m_code.size();
+
+	instruction.op = tree.op;
+	instruction.negated = (tree.negated ? 1 : 0);
+	instruction.shift = tree.shift;
+	instruction.end = 0;
+	m_code.push_back( instruction );
+	for( unsigned int i = 0; i < tree.operands.size(); i++ )
+		this->emit( tree.operands[i] );
+	m_code[pc].end = (uint32_t)m_code.size();
+}
+
+bool CShortCircuitProgram::compile( const CExpressionGraph& graph, int output )
+{
+	const std::vector<char>& variables = graph.getUniqueVariables();
+	unsigned char shifts[INPUT_SLOT_COUNT] = { 0 };
+
+	m_nodes.clear();
+	m_code.clear();
+	m_compiled = false;
+
+	for( unsigned int i = 0; i < variables.size(); i++ )
+		shifts[variables[i] - 'A'] = (unsigned char)(variables.size() - 1 - i);
+	m_root = this->expand( graph, graph.getOutput( output ), shifts );
+	if( m_root == -1 ) {
+		m_nodes.clear();
+		return false;
+	}
+
+	// Until there is a profile every operand is assumed to run
+	for( unsigned int i = 0; i < m_nodes.size(); i++ ) {
+		m_nodes[i].cost = 1.0;
+		for( unsigned int j = 0; j < m_nodes[i].operands.size(); j++ )
+			m_nodes[i].cost += m_nodes[m_nodes[i].operands[j]].cost;
+	}
+	this->emit( m_root );
+	m_compiled = true;
+	return true;
+}
+
+void CShortCircuitProgram::profile( const uint64_t *pRows, size_t count )
+{
+	std::vector<uint8_t> values;
+	std::vector<double> decisive;
+	size_t stride, samples;
+
+	if( !m_compiled || count == 0 )
+		return;
+
+	// Spread the samples over the whole set rather than taking the first ones
+	stride = (count + SHORT_CIRCUIT_PROFILE_SAMPLES - 1) / SHORT_CIRCUIT_PROFILE_SAMPLES;
+	samples = (count + stride - 1) / stride;
+
+	values.resize( m_nodes.size() );
+	decisive.resize( m_nodes.size() );
+	for( unsigned int i = 0; i < m_nodes.size(); i++ )
+		m_nodes[i].trueCount = 0;
+	for( size_t sample = 0; sample < samples; sample++ )
+	{
+		uint64_t row = pRows[sample * stride];
+
+		// Operands come first, so one pass in order evaluates everything
+		for( unsigned int i = 0; i < m_nodes.size(); i++ )
+		{
+			const TreeNode& tree = m_nodes[i];
+			bool value = false;
+
+			switch( tree.op )
+			{
+			case NODE_TYPE_CONST1:
+				value = true;
+				break;
+			case NODE_TYPE_VARIABLE:
+				value = ((row >> tree.shift) & 1) != 0;
+				break;
+			case NODE_TYPE_AND:
+				value = true;
+				for( unsigned int j = 0; j < tree.operands.size(); j++ )
+					value = value && values[tree.operands[j]];
+				break;
+			case NODE_TYPE_OR:
+				for( unsigned int j = 0; j < tree.operands.size(); j++ )
+					value = value || values[tree.operands[j]];
+				break;
+			case NODE_TYPE_XOR:
+				for( unsigned int j = 0; j < tree.operands.size(); j++ )
+					value = value != (values[tree.operands[j]] != 0);
+				break;
+			}
+			value = (value != tree.negated);
+			values[i] = (value ? 1 : 0);
+			if( value )
+				m_nodes[i].trueCount++;
+		}
+	}
+
+	// Sorting by cost over the chance of deciding the result is the best
+	// order for independent operands. Costs are worked out bottom up, so
+	// each node sees the expected cost of its already sorted operands.
+	for( unsigned int i = 0; i < m_nodes.size(); i++ )
+	{
+		TreeNode& tree = m_nodes[i];
+		double reached = 1.0;
+
+		if( tree.op == NODE_TYPE_AND || tree.op == NODE_TYPE_OR )
+		{
+			for( unsigned int j = 0; j < tree.operands.size(); j++ ) {
+				int operand = tree.operands[j];
+				double trueRate = (double)m_nodes[operand].trueCount / (double)samples;
+				decisive[operand] = (tree.op == NODE_TYPE_AND ? 1.0 - trueRate : trueRate);
+			}
+			// Cross multiplied so operands that never decide anything go last
+			std::stable_sort( tree.operands.begin(), tree.operands.end(), [&]( int a, int b ) {
+				return m_nodes[a].cost * decisive[b] < m_nodes[b].cost * decisive[a];
+			} );
+		}
+
+		tree.cost = 1.0;
+		for( unsigned int j = 0; j < tree.operands.size(); j++ ) {
+			int operand = tree.operands[j];
+			tree.cost += reached * m_nodes[operand].cost;
+			if( tree.op != NODE_TYPE_XOR )
+				reached *= 1.0 - decisive[operand];
+		}
+	}
+
+	m_code.clear();
+	this->emit( m_root );
+}
+
+bool CShortCircuitProgram::evaluateAt( uint32_t pc, uint64_t row, uint32_t *pExecuted ) const
+{
+	const ShortCircuitInstruction& instruction = m_code[pc];
+	bool value = false;
+
+	(*pExecuted)++;
+	switch( instruction.op )
+	{
+	case NODE_TYPE_CONST1:
+		value = true;
+		break;
+	case NODE_TYPE_VARIABLE:
+		value = ((row >> instruction.shift) & 1) != 0;
+		break;
+	case NODE_TYPE_AND:
+		// Each operand's end is where the next one starts
+		value = true;
+		for( uint32_t operand = pc + 1; operand < instruction.end && value; operand = m_code[operand].end )
+			value = this->evaluateAt( operand, row, pExecuted );
+		break;
+	case NODE_TYPE_OR:
+		for( uint32_t operand = pc + 1; operand < instruction.end && !value; operand = m_code[operand].end )
+			value = this->evaluateAt( operand, row, pExecuted );
+		break;
+	case NODE_TYPE_XOR:
+		for( uint32_t operand = pc + 1; operand < instruction.end; operand = m_code[operand].end )
+			value = value != this->evaluateAt( operand, row, pExecuted );
+		break;
+	}
+	return value != (instruction.negated != 0);
+}
+
+bool CShortCircuitProgram::evaluate( uint64_t row ) const
+{
+	uint32_t executed = 0;
+	bool value;
+
+	if( !m_compiled )
+		return false;
+	value = this->evaluateAt( 0, row, &executed );
+
+	STATS_INCREMENT( STAT_ROWS_EVALUATED );
+	STATS_ADD( STAT_NODES_VISITED, executed );
+	return value;
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+#include "expressiongraph.h"
+
+// Compiling gives up past this many nodes, shared subterms are copied out
+// so a DAG can grow a lot when it is turned into a tree
+#define SHORT_CIRCUIT_MAX_NODES 65536
+// profile() looks at no more than this many of the rows it is given
+#define SHORT_CIRCUIT_PROFILE_SAMPLES 1024
+
+// op is one of the NODE_TYPE values, NOT never appears since it is folded
+// into the negated flag. Operands follow their AND/OR/XOR in order and end
+// is the index just past the whole subtree, which is where evaluation jumps
+// once an operand decides the result.
+struct ShortCircuitInstruction
+{
+	unsigned char op;
+	unsigned char negated;
+	unsigned char shift;
+	uint32_t end;
+};
+
+// An output lowered to a tree of n-ary AND/OR/XOR for evaluating one row at
+// a time. An AND stops at its first false operand and an OR at its first
+// true one, so 0*X and 1+X never look at X. Rows are packed the same way
+// as truth table rows.
+class CShortCircuitProgram
+{
+private:
+	struct TreeNode
+	{
+		unsigned char op;
+		bool negated;
+		unsigned char shift;
+		std::vector<int> operands;
+		uint32_t trueCount;
+		// Instructions run per evaluation, estimated from the profile
+		double cost;
+	};
+
+	// Operands come before the nodes using them
+	std::vector<TreeNode> m_nodes;
+	std::vector<ShortCircuitInstruction> m_code;
+	int m_root;
+	bool m_compiled;
+
+	int expand( const CExpressionGraph& graph, int node, const unsigned char *pShifts );
+	void gatherOperands( const CExpressionGraph& graph, int node, unsigned char nodeType, std::vector<int> *pOperands ) const;
+	void emit( int node );
+	bool evaluateAt( uint32_t pc, uint64_t row, uint32_t *pExecuted ) const;
+public:
+	CShortCircuitProgram();
+	~CShortCircuitProgram();
+
+	bool compile( const CExpressionGraph& graph, int output );
+	// Evaluates sample rows in full, counts how often each operand comes out
+	// true and reorders the operands of every AND/OR so the ones most likely
+	// to decide it for the least work are tried first
+	void profile( const uint64_t *pRows, size_t count );
+
+	bool evaluate( uint64_t row ) const;
+
+	inline bool isCompiled() const { return m_compiled; }
+	inline uint32_t getInstructionCount() const { return (uint32_t)m_code.size(); }
+	// Average instructions per row under the last profile, every instruction
+	// before there is one
+	inline double getExpectedCost() const { return (m_compiled ? m_nodes[m_root].cost : 0.0); }
+};
@@ -0,0 +1,124 @@
+#include "signature.h"
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <unordered_map>
+#include "equationparser.h"
+#include "equivalence.h"
+
+// Equations are parsed and signed in small batches
+#define SIGNATURE_BATCH_SIZE 64
+
+static uint64_t SplitMix64( uint64_t value )
+{
+	value += 0x9E3779B97F4A7C15ULL;
+	value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	value = (value ^ (value >> 27)) * 0x94D049BB133111EBULL;
+	return value ^ (value >> 31);
+}
+
+void ComputeSignature( const CExpressionGraph& graph, int output, SimulationSignature *pSignature )
+{
+	std::vector<uint64_t> values( graph.getNodeCount() );
+	uint64_t slots[INPUT_SLOT_COUNT];
+
+	for( int i = 0; i < SIGNATURE_WORDS; i++ )
+	{
+		for( int j = 0; j < INPUT_SLOT_COUNT; j++ )
+			slots[j] = SplitMix64( (uint64_t)(i * INPUT_SLOT_COUNT + j) );
+		graph.evaluateWord( slots, &values[0] );
+		pSignature->words[i] = values[graph.getOutput( output )];
+	}
+}
+
+CEquivalenceClasses::CEquivalenceClasses() {
+	m_classCount = 0;
+	m_bucketCount = 0;
+	m_exactChecks = 0;
+}
+CEquivalenceClasses::~CEquivalenceClasses() {
+}
+
+void CEquivalenceClasses::classify( const std::vector<std::string>& equations, CTaskScheduler& scheduler )
+{
+	std::vector<SimulationSignature> signatures( equations.size() );
+	std::atomic<uint64_t> exactChecks( 0 );
+	CTaskGroup group;
+
+	m_graphs.assign( equations.size(), CExpressionGraph() );
+	m_classes.assign( equations.size(), -1 );
+
+	// Parse and sign everything
+	for( size_t start = 0; start < equations.size(); start += SIGNATURE_BATCH_SIZE )
+	{
+		size_t end = std::min( start + SIGNATURE_BATCH_SIZE, equations.size() );
+		scheduler.submit( group, [this, &equations, &signatures, start, end]() {
+			for( size_t i = start; i < end; i++ )
+			{
+				CEquationParser parser;
+				int parseError;
+				if( !parser.parse( equations[i], &parseError ) || !m_graphs[i].addEquation( parser, &parseError ) )
+					continue;
+				ComputeSignature( m_graphs[i], 0, &signatures[i] );
+				m_classes[i] = (int)i;
+			}
+		} );
+	}
+	scheduler.wait( group );
+
+	// Bucket by signature, keeping the input order inside each bucket
+	std::unordered_map<SimulationSignature, std::vector<int>, SimulationSignatureHash> bucketLookup;
+	for( unsigned int i = 0; i < equations.size(); i++ ) {
+		if( m_classes[i] != -1 )
+			bucketLookup[signatures[i]].push_back( i );
+	}
+	std::vector<std::vector<int>> buckets;
+	buckets.reserve( bucketLookup.size() );
+	for( auto it = bucketLookup.begin(); it != bucketLookup.end(); it++ )
+		buckets.push_back( std::move( (*it).second ) );
+	m_bucketCount = (int)buckets.size();
+
+	// Exact checks only inside a bucket, each equation ends up pointing at
+	// the first equation of its class
+	for( unsigned int i = 0; i < buckets.size(); i++ )
+	{
+		if( buckets[i].size() == 1 )
+			continue;
+		const std::vector<int> *pBucket = &buckets[i];
+		scheduler.submit( group, [this, pBucket, &exactChecks]() {
+			std::vector<int> representatives;
+			for( auto it = pBucket->begin(); it != pBucket->end(); it++ )
+			{
+				bool found = false;
+				for( auto rep = representatives.begin(); rep != representatives.end(); rep++ )
+				{
+					EquivalenceResult result;
+					CheckEquivalence( m_graphs[(*rep)], 0, m_graphs[(*it)], 0, &result );
+					exactChecks++;
+					if( result.equal ) {
+						m_classes[(*it)] = (*rep);
+						found = true;
+						break;
+					}
+				}
+				if( !found )
+					representatives.push_back( (*it) );
+			}
+		} );
+	}
+	scheduler.wait( group );
+	m_exactChecks = exactChecks;
+
+	// Number the classes in order of first appearance
+	std::map<int, int> classNumbers;
+	for( unsigned int i = 0; i < m_classes.size(); i++ )
+	{
+		if( m_classes[i] == -1 )
+			continue;
+		auto it = classNumbers.find( m_classes[i] );
+		if( it == classNumbers.end() )
+			it = classNumbers.insert( std::make_pair( m_classes[i], (int)classNumbers.size() ) ).first;
+		m_classes[i] = (*it).second;
+	}
+	m_classCount = (int)classNumbers.size();
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "expressiongraph.h"
+#include "scheduler.h"
+
+#define SIGNATURE_WORDS 4
+
+// The outputs of an equation on a fixed set of pseudo-random inputs. Every
+// letter always gets the same input words, so equations over different
+// variables can still share a signature when they are the same function.
+struct SimulationSignature
+{
+	uint64_t words[SIGNATURE_WORDS];
+
+	inline bool operator==( const SimulationSignature& rhs ) const {
+		for( int i = 0; i < SIGNATURE_WORDS; i++ ) {
+			if( words[i] != rhs.words[i] )
+				return false;
+		}
+		return true;
+	}
+};
+
+struct SimulationSignatureHash
+{
+	inline size_t operator()( const SimulationSignature& signature ) const {
+		return (size_t)(signature.words[0] ^ (signature.words[1] * 0x9E3779B97F4A7C15ULL));
+	}
+};
+
+void ComputeSignature( const CExpressionGraph& graph, int output, SimulationSignature *pSignature );
+
+// Splits a set of equations into classes of identical functions. Equations
+// are bucketed by signature and only compared exactly inside a bucket.
+class CEquivalenceClasses
+{
+private:
+	std::vector<CExpressionGraph> m_graphs;
+	std::vector<int> m_classes;
+	int m_classCount;
+	int m_bucketCount;
+	uint64_t m_exactChecks;
+public:
+	CEquivalenceClasses();
+	~CEquivalenceClasses();
+
+	void classify( const std::vector<std::string>& equations, CTaskScheduler& scheduler );
+
+	// -1 for equations that didn't parse
+	inline int getClass( int equation ) const { return m_classes[equation]; }
+	inline int getClassCount() const { return m_classCount; }
+	inline int getBucketCount() const { return m_bucketCount; }
+	inline uint64_t getExactCheckCount() const { return m_exactChecks; }
+};
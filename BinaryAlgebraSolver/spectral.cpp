@@ -0,0 +1,202 @@
+#include "spectral.h"
+#include <algorithm>
+#include "util.h"
+
+// Butterflies for every stride below blockSize inside one block
+static void TransformBlock( int32_t *pBlock, uint64_t blockSize )
+{
+	for( uint64_t stride = 1; stride < blockSize; stride <<= 1 ) {
+		for( uint64_t i = 0; i < blockSize; i += stride << 1 ) {
+			int32_t *pLow = pBlock + i, *pHigh = pBlock + i + stride;
+			for( uint64_t j = 0; j < stride; j++ ) {
+				int32_t a = pLow[j], b = pHigh[j];
+				pLow[j] = a + b;
+				pHigh[j] = a - b;
+			}
+		}
+	}
+}
+
+void ComputeWalshSpectrum( const CTruthTable& table, std::vector<int32_t> *pSpectrum, CTaskScheduler& scheduler )
+{
+	uint64_t size = table.getRowCount();
+	uint64_t blockSize = std::min( size, (uint64_t)SPECTRAL_BLOCK_SIZE );
+	int32_t *pData;
+	CTaskGroup group;
+
+	pSpectrum->resize( (size_t)size );
+	pData = &(*pSpectrum)[0];
+
+	// Signs of the table and the in-cache strides, one task per block
+	for( uint64_t start = 0; start < size; start += blockSize )
+	{
+		scheduler.submit( group, [&table, pData, start, blockSize]() {
+			const std::vector<uint64_t>& words = table.getWords();
+			for( uint64_t i = start; i < start + blockSize; i++ )
+				pData[i] = 1 - 2 * (int32_t)((words[i >> 6] >> (i & 63)) & 1);
+			TransformBlock( pData + start, blockSize );
+		} );
+	}
+	scheduler.wait( group );
+
+	// Wider strides pair up whole blocks, a chunk of blockSize butterflies
+	// never crosses a group since the stride is at least that big
+	for( uint64_t stride = blockSize; stride < size; stride <<= 1 )
+	{
+		for( uint64_t first = 0; first < size / 2; first += blockSize )
+		{
+			scheduler.submit( group, [pData, stride, first, blockSize]() {
+				int32_t *pLow = pData + (first / stride) * (stride << 1) + (first % stride);
+				int32_t *pHigh = pLow + stride;
+				for( uint64_t j = 0; j < blockSize; j++ ) {
+					int32_t a = pLow[j], b = pHigh[j];
+					pLow[j] = a + b;
+					pHigh[j] = a - b;
+				}
+			} );
+		}
+		scheduler.wait( group );
+	}
+}
+
+// Compares the two halves of the table split on one row bit
+static void AnalyzeVariable( const CTruthTable& table, unsigned int bit, VariableProperties *pProperties )
+{
+	const std::vector<uint64_t>& words = table.getWords();
+	uint64_t flips = 0, falling = 0, rising = 0;
+
+	if( bit < 6 )
+	{
+		uint64_t valid = ~CTruthTable::getLaneMask( bit ) & table.getLastWordMask();
+		for( auto it = words.begin(); it != words.end(); it++ ) {
+			uint64_t low = (*it) & valid;
+			uint64_t high = ((*it) >> (1 << bit)) & valid;
+			flips += CountSetBits( low ^ high );
+			falling += CountSetBits( low & ~high );
+			rising += CountSetBits( ~low & high & valid );
+		}
+	}
+	else
+	{
+		uint64_t stride = (uint64_t)1 << (bit - 6);
+		for( uint64_t i = 0; i < words.size(); i++ ) {
+			if( i & stride )
+				continue;
+			uint64_t low = words[i], high = words[i + stride];
+			flips += CountSetBits( low ^ high );
+			falling += CountSetBits( low & ~high );
+			rising += CountSetBits( ~low & high );
+		}
+	}
+
+	pProperties->influence = (double)flips / (double)(table.getRowCount() / 2);
+	if( flips == 0 )
+		pProperties->unateness = UNATE_INDEPENDENT;
+	else if( falling == 0 )
+		pProperties->unateness = UNATE_POSITIVE;
+	else if( rising == 0 )
+		pProperties->unateness = UNATE_NEGATIVE;
+	else
+		pProperties->unateness = UNATE_BINATE;
+}
+
+// Whether swapping row bits low < high leaves the table unchanged. Rows
+// with low set and high clear are compared with the row that has them the
+// other way around.
+static bool IsSymmetricPair( const CTruthTable& table, unsigned int low, unsigned int high )
+{
+	const std::vector<uint64_t>& words = table.getWords();
+
+	if( high < 6 )
+	{
+		uint64_t mask = CTruthTable::getLaneMask( low ) & ~CTruthTable::getLaneMask( high );
+		unsigned int distance = (1 << high) - (1 << low);
+		for( auto it = words.begin(); it != words.end(); it++ ) {
+			if( ((*it) ^ ((*it) >> distance)) & mask )
+				return false;
+		}
+	}
+	else if( low < 6 )
+	{
+		uint64_t mask = CTruthTable::getLaneMask( low );
+		uint64_t stride = (uint64_t)1 << (high - 6);
+		for( uint64_t i = 0; i < words.size(); i++ ) {
+			if( i & stride )
+				continue;
+			if( (words[i] ^ (words[i + stride] << (1 << low))) & mask )
+				return false;
+		}
+	}
+	else
+	{
+		uint64_t lowStride = (uint64_t)1 << (low - 6), highStride = (uint64_t)1 << (high - 6);
+		for( uint64_t i = 0; i < words.size(); i++ ) {
+			if( !(i & lowStride) || (i & highStride) )
+				continue;
+			if( words[i] != words[i - lowStride + highStride] )
+				return false;
+		}
+	}
+	return true;
+}
+
+void AnalyzeFunction( const CTruthTable& table, std::vector<int32_t> *pSpectrum, FunctionProperties *pProperties, CTaskScheduler& scheduler )
+{
+	unsigned int variableCount = table.getVariableCount();
+	uint64_t size = table.getRowCount();
+
+	pProperties->variables.assign( variableCount, VariableProperties() );
+	pProperties->symmetricPairs.assign( variableCount * variableCount, true );
+
+	// Per variable and per pair work is queued before the transform, so
+	// idle workers pick it up while the spectrum is built
+	std::vector<char> pairResults( variableCount * variableCount, 1 );
+	CTaskGroup group;
+	for( unsigned int i = 0; i < variableCount; i++ )
+	{
+		VariableProperties *pVariable = &pProperties->variables[i];
+		scheduler.submit( group, [&table, variableCount, i, pVariable]() {
+			AnalyzeVariable( table, variableCount - 1 - i, pVariable );
+		} );
+		for( unsigned int j = i + 1; j < variableCount; j++ )
+		{
+			char *pResult = &pairResults[i * variableCount + j];
+			scheduler.submit( group, [&table, variableCount, i, j, pResult]() {
+				(*pResult) = IsSymmetricPair( table, variableCount - 1 - j, variableCount - 1 - i ) ? 1 : 0;
+			} );
+		}
+	}
+	ComputeWalshSpectrum( table, pSpectrum, scheduler );
+	scheduler.wait( group );
+
+	pProperties->totallySymmetric = true;
+	for( unsigned int i = 0; i < variableCount; i++ ) {
+		for( unsigned int j = i + 1; j < variableCount; j++ ) {
+			bool symmetric = (pairResults[i * variableCount + j] != 0);
+			pProperties->symmetricPairs[i * variableCount + j] = symmetric;
+			pProperties->symmetricPairs[j * variableCount + i] = symmetric;
+			if( !symmetric )
+				pProperties->totallySymmetric = false;
+		}
+	}
+
+	// W(0) is rows minus twice the ones
+	const std::vector<int32_t>& spectrum = *pSpectrum;
+	pProperties->ones = (uint64_t)(((int64_t)size - spectrum[0]) / 2);
+	pProperties->balanced = (spectrum[0] == 0);
+	pProperties->maxWalsh = 0;
+	pProperties->maxWalshIndex = 0;
+	for( uint64_t i = 0; i < size; i++ ) {
+		uint64_t magnitude = (uint64_t)(spectrum[i] < 0 ? -(int64_t)spectrum[i] : spectrum[i]);
+		if( magnitude > pProperties->maxWalsh ) {
+			pProperties->maxWalsh = magnitude;
+			pProperties->maxWalshIndex = i;
+		}
+	}
+
+	// Distance to the closest affine function, zero only for affine ones,
+	// which are linear when the one coefficient is positive
+	pProperties->nonlinearity = (size - pProperties->maxWalsh) / 2;
+	pProperties->affine = (pProperties->maxWalsh == size);
+	pProperties->linear = pProperties->affine && spectrum[pProperties->maxWalshIndex] > 0;
+}
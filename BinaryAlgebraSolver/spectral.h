@@ -0,0 +1,50 @@
+#pragma once
+#include <stdint.h>
+#include <vector>
+#include "scheduler.h"
+#include "truthtable.h"
+
+// Butterflies over strides below this many entries are done in one task,
+// so a block stays in cache for all of them
+#define SPECTRAL_BLOCK_SIZE 16384
+// Past this many variables the whole spectrum isn't printed
+#define SPECTRUM_MAX_LIST_VARIABLES 6
+
+enum
+{
+	UNATE_INDEPENDENT,
+	UNATE_POSITIVE,
+	UNATE_NEGATIVE,
+	UNATE_BINATE
+};
+
+struct VariableProperties
+{
+	// Fraction of inputs where flipping the variable flips the output
+	double influence;
+	int unateness;
+};
+
+struct FunctionProperties
+{
+	uint64_t ones;
+	bool balanced;
+	bool affine;
+	bool linear;
+	uint64_t nonlinearity;
+	// Largest absolute Walsh coefficient and where it is
+	uint64_t maxWalsh;
+	uint64_t maxWalshIndex;
+	std::vector<VariableProperties> variables;
+	// Row major, entry i*n+j is set when swapping variables i and j leaves
+	// the function unchanged
+	std::vector<bool> symmetricPairs;
+	bool totallySymmetric;
+};
+
+// Walsh-Hadamard spectrum, W(a) is the sum over x of (-1)^(f(x) ^ a.x).
+// Coefficients are indexed like rows, so bit n-1 of a is the first variable.
+void ComputeWalshSpectrum( const CTruthTable& table, std::vector<int32_t> *pSpectrum, CTaskScheduler& scheduler );
+// Everything but the symmetry and unateness comes from the spectrum, which
+// is left in pSpectrum for the caller
+void AnalyzeFunction( const CTruthTable& table, std::vector<int32_t> *pSpectrum, FunctionProperties *pProperties, CTaskScheduler& scheduler );
@@ -0,0 +1,98 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+// Bounded lock-free ring buffer for exactly one producer and one consumer.
+// tryPush fails when the ring is full, tryPop fails when it's empty, so the
+// caller decides how to wait. The producer closes it after its last push.
+// After spinning for a while a side can block in waitForSpace/waitForItem,
+// the other side only touches the mutex when someone is asleep.
+template <typename T>
+class CSpscQueue
+{
+private:
+	std::vector<T> m_items;
+	size_t m_mask;
+	alignas(64) std::atomic<size_t> m_head;
+	alignas(64) std::atomic<size_t> m_tail;
+	alignas(64) std::atomic<bool> m_closed;
+	std::atomic<int> m_sleepers;
+	std::mutex m_mutex;
+	std::condition_variable m_condition;
+
+	void wake()
+	{
+		// Pairs with the fence in wait(), either the sleeper sees the change
+		// or this sees the sleeper
+		std::atomic_thread_fence( std::memory_order_seq_cst );
+		if( m_sleepers.load( std::memory_order_relaxed ) != 0 ) {
+			std::lock_guard<std::mutex> lock( m_mutex );
+			m_condition.notify_all();
+		}
+	}
+	template <typename Ready>
+	void wait( Ready ready )
+	{
+		std::unique_lock<std::mutex> lock( m_mutex );
+		m_sleepers.fetch_add( 1, std::memory_order_relaxed );
+		std::atomic_thread_fence( std::memory_order_seq_cst );
+		m_condition.wait( lock, ready );
+		m_sleepers.fetch_sub( 1, std::memory_order_relaxed );
+	}
+public:
+	CSpscQueue( size_t capacity )
+	{
+		// Round up to a power of two so wrapping is a mask
+		size_t size = 1;
+		while( size < capacity )
+			size <<= 1;
+		m_items.resize( size );
+		m_mask = size - 1;
+		m_head = 0;
+		m_tail = 0;
+		m_closed = false;
+		m_sleepers = 0;
+	}
+
+	bool tryPush( T& item )
+	{
+		size_t tail = m_tail.load( std::memory_order_relaxed );
+		if( tail - m_head.load( std::memory_order_acquire ) > m_mask )
+			return false;
+		m_items[tail & m_mask] = std::move( item );
+		m_tail.store( tail + 1, std::memory_order_release );
+		this->wake();
+		return true;
+	}
+	bool tryPop( T *pItem )
+	{
+		size_t head = m_head.load( std::memory_order_relaxed );
+		if( head == m_tail.load( std::memory_order_acquire ) )
+			return false;
+		*pItem = std::move( m_items[head & m_mask] );
+		m_head.store( head + 1, std::memory_order_release );
+		this->wake();
+		return true;
+	}
+
+	// Producer side, returns once there is room for a push
+	void waitForSpace() {
+		this->wait( [this]() { return m_tail.load( std::memory_order_relaxed ) - m_head.load( std::memory_order_acquire ) <= m_mask; } );
+	}
+	// Consumer side, returns once there is an item or the queue is closed
+	void waitForItem() {
+		this->wait( [this]() { return m_head.load( std::memory_order_relaxed ) != m_tail.load( std::memory_order_acquire ) || this->isClosed(); } );
+	}
+
+	void close() {
+		m_closed.store( true, std::memory_order_release );
+		this->wake();
+	}
+	inline bool isClosed() const { return m_closed.load( std::memory_order_acquire ); }
+
+	// Only a snapshot when the other side is running
+	inline size_t size() const { return m_tail.load( std::memory_order_acquire ) - m_head.load( std::memory_order_acquire ); }
+	inline size_t getCapacity() const { return m_mask + 1; }
+};
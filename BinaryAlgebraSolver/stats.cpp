@@ -0,0 +1,165 @@
+#include "stats.h"
+#include <atomic>
+#include <chrono>
+#include "jsonline.h"
+
+// Threads get their own slot so counting doesn't bounce cache lines, the
+// slots are only summed when the report is printed
+#define STATS_SLOT_COUNT 256
+
+static const char *g_statNames[STAT_COUNT] = {
+	"equations_parsed",
+	"tokens",
+	"implicit_ands",
+	"rows_evaluated",
+	"rows_pruned",
+	"words_evaluated",
+	"nodes_visited",
+	"variable_lookups",
+	"donkey_scans",
+	"allocations",
+	"bytes_allocated"
+};
+static const char *g_statDescriptions[STAT_COUNT] = {
+	"Equations parsed",
+	"Tokens produced",
+	"Implicit ANDs inserted",
+	"Rows evaluated",
+	"Rows from constant cofactors",
+	"Words evaluated (64 rows)",
+	"Nodes visited",
+	"Variable lookups",
+	"Donkey list scans",
+	"Allocations",
+	"Bytes allocated"
+};
+static const char *g_phaseNames[STATS_PHASE_COUNT] = { "parse", "evaluate", "compare", "print" };
+
+#ifdef ENABLE_STATS
+struct StatsSlot
+{
+	alignas(64) std::atomic<uint64_t> counters[STAT_COUNT];
+	std::atomic<uint64_t> phaseNs[STATS_PHASE_COUNT];
+	std::atomic<uint64_t> phaseCalls[STATS_PHASE_COUNT];
+};
+
+static StatsSlot g_slots[STATS_SLOT_COUNT];
+static std::atomic<unsigned int> g_nextSlot( 0 );
+static thread_local int t_slot = -1;
+
+static StatsSlot& GetSlot()
+{
+	if( t_slot == -1 )
+		t_slot = (int)(g_nextSlot++ % STATS_SLOT_COUNT);
+	return g_slots[t_slot];
+}
+
+void AddStat( int counter, uint64_t value ) {
+	GetSlot().counters[counter].fetch_add( value, std::memory_order_relaxed );
+}
+void AddPhaseTime( int phase, uint64_t ns )
+{
+	StatsSlot& slot = GetSlot();
+	slot.phaseNs[phase].fetch_add( ns, std::memory_order_relaxed );
+	slot.phaseCalls[phase].fetch_add( 1, std::memory_order_relaxed );
+}
+uint64_t GetStatsTimeNs() {
+	return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now().time_since_epoch() ).count();
+}
+#endif
+
+bool IsStatsEnabled()
+{
+#ifdef ENABLE_STATS
+	return true;
+#else
+	return false;
+#endif
+}
+
+uint64_t GetStat( int counter )
+{
+	uint64_t total = 0;
+#ifdef ENABLE_STATS
+	for( int i = 0; i < STATS_SLOT_COUNT; i++ )
+		total += g_slots[i].counters[counter].load( std::memory_order_relaxed );
+#else
+	(void)counter;
+#endif
+	return total;
+}
+uint64_t GetPhaseTime( int phase )
+{
+	uint64_t total = 0;
+#ifdef ENABLE_STATS
+	for( int i = 0; i < STATS_SLOT_COUNT; i++ )
+		total += g_slots[i].phaseNs[phase].load( std::memory_order_relaxed );
+#else
+	(void)phase;
+#endif
+	return total;
+}
+uint64_t GetPhaseCalls( int phase )
+{
+	uint64_t total = 0;
+#ifdef ENABLE_STATS
+	for( int i = 0; i < STATS_SLOT_COUNT; i++ )
+		total += g_slots[i].phaseCalls[phase].load( std::memory_order_relaxed );
+#else
+	(void)phase;
+#endif
+	return total;
+}
+
+void ResetStats()
+{
+#ifdef ENABLE_STATS
+	for( int i = 0; i < STATS_SLOT_COUNT; i++ ) {
+		for( int j = 0; j < STAT_COUNT; j++ )
+			g_slots[i].counters[j] = 0;
+		for( int j = 0; j < STATS_PHASE_COUNT; j++ ) {
+			g_slots[i].phaseNs[j] = 0;
+			g_slots[i].phaseCalls[j] = 0;
+		}
+	}
+#endif
+}
+
+void PrintStats( FILE *pFile, int report )
+{
+	if( report == STATS_REPORT_NONE )
+		return;
+	if( !IsStatsEnabled() ) {
+		fprintf( pFile, "Statistics were not compiled in, rebuild with ENABLE_STATS\n" );
+		return;
+	}
+
+	// Taken up front so printing doesn't count itself
+	uint64_t counters[STAT_COUNT], phaseNs[STATS_PHASE_COUNT], phaseCalls[STATS_PHASE_COUNT];
+	for( int i = 0; i < STAT_COUNT; i++ )
+		counters[i] = GetStat( i );
+	for( int i = 0; i < STATS_PHASE_COUNT; i++ ) {
+		phaseNs[i] = GetPhaseTime( i );
+		phaseCalls[i] = GetPhaseCalls( i );
+	}
+
+	if( report == STATS_REPORT_JSON )
+	{
+		CJsonWriter writer;
+		for( int i = 0; i < STAT_COUNT; i++ )
+			writer.addNumber( g_statNames[i], (int64_t)counters[i] );
+		for( int i = 0; i < STATS_PHASE_COUNT; i++ ) {
+			writer.addNumber( std::string( g_phaseNames[i] ) + "_calls", (int64_t)phaseCalls[i] );
+			writer.addNumber( std::string( g_phaseNames[i] ) + "_ms", phaseNs[i] / 1e6 );
+		}
+		fprintf( pFile, "%s\n", writer.finish().c_str() );
+		return;
+	}
+
+	fprintf( pFile, "\nStatistics:\n" );
+	for( int i = 0; i < STAT_COUNT; i++ )
+		fprintf( pFile, " %-28s %llu\n", g_statDescriptions[i], (unsigned long long)counters[i] );
+	fprintf( pFile, " %-10s %12s %12s\n", "Phase", "Calls", "Total ms" );
+	for( int i = 0; i < STATS_PHASE_COUNT; i++ )
+		fprintf( pFile, " %-10s %12llu %12.3f\n", g_phaseNames[i], (unsigned long long)phaseCalls[i], phaseNs[i] / 1e6 );
+}
@@ -0,0 +1,76 @@
+#pragma once
+#include <stdint.h>
+#include <stdio.h>
+
+// Counters and phase timers for --stats. Everything here compiles away
+// unless ENABLE_STATS is defined, so the macros are safe on hot paths.
+
+enum
+{
+	STAT_EQUATIONS_PARSED,
+	STAT_TOKENS,
+	STAT_IMPLICIT_ANDS,
+	STAT_ROWS_EVALUATED,
+	STAT_ROWS_PRUNED,
+	STAT_WORDS_EVALUATED,
+	STAT_NODES_VISITED,
+	STAT_VARIABLE_LOOKUPS,
+	STAT_DONKEY_SCANS,
+	STAT_ALLOCATIONS,
+	STAT_BYTES_ALLOCATED,
+	STAT_COUNT
+};
+
+enum
+{
+	STATS_PHASE_PARSE,
+	STATS_PHASE_EVALUATE,
+	STATS_PHASE_COMPARE,
+	STATS_PHASE_PRINT,
+	STATS_PHASE_COUNT
+};
+
+enum
+{
+	STATS_REPORT_NONE,
+	STATS_REPORT_TEXT,
+	STATS_REPORT_JSON
+};
+
+#ifdef ENABLE_STATS
+void AddStat( int counter, uint64_t value );
+void AddPhaseTime( int phase, uint64_t ns );
+uint64_t GetStatsTimeNs();
+
+class CStatsTimer
+{
+private:
+	int m_phase;
+	uint64_t m_start;
+public:
+	CStatsTimer( int phase ) {
+		m_phase = phase;
+		m_start = GetStatsTimeNs();
+	}
+	~CStatsTimer() {
+		AddPhaseTime( m_phase, GetStatsTimeNs() - m_start );
+	}
+};
+
+#define STATS_ADD( counter, value ) AddStat( (counter), (uint64_t)(value) )
+#define STATS_INCREMENT( counter ) AddStat( (counter), 1 )
+#define STATS_CONCAT_INNER( a, b ) a##b
+#define STATS_CONCAT( a, b ) STATS_CONCAT_INNER( a, b )
+#define STATS_TIMER( phase ) CStatsTimer STATS_CONCAT( statsTimer, __LINE__ )( phase )
+#else
+#define STATS_ADD( counter, value ) ((void)0)
+#define STATS_INCREMENT( counter ) ((void)0)
+#define STATS_TIMER( phase ) ((void)0)
+#endif
+
+bool IsStatsEnabled();
+uint64_t GetStat( int counter );
+uint64_t GetPhaseTime( int phase );
+uint64_t GetPhaseCalls( int phase );
+void ResetStats();
+void PrintStats( FILE *pFile, int report );
@@ -0,0 +1,132 @@
+#include "truthtable.h"
+#include "util.h"
+
+// Lanes within a word where bit p of the row index is set
+static const uint64_t g_laneMasks[6] = {
+	0xAAAAAAAAAAAAAAAAULL,
+	0xCCCCCCCCCCCCCCCCULL,
+	0xF0F0F0F0F0F0F0F0ULL,
+	0xFF00FF00FF00FF00ULL,
+	0xFFFF0000FFFF0000ULL,
+	0xFFFFFFFF00000000ULL
+};
+
+uint64_t CTruthTable::getLaneMask( unsigned int bit ) {
+	return g_laneMasks[bit];
+}
+
+uint64_t CTruthTable::getWordCount( unsigned int variableCount )
+{
+	if( variableCount <= 6 )
+		return 1;
+	return (uint64_t)1 << (variableCount - 6);
+}
+
+void CTruthTable::fillInputSlots( const std::vector<char>& uniqueVariables, uint64_t wordIndex, uint64_t *pSlots )
+{
+	unsigned int variableCount = (unsigned int)uniqueVariables.size();
+
+	for( unsigned int i = 0; i < variableCount; i++ )
+	{
+		// The first variable is the most significant bit of the row
+		unsigned int bit = variableCount - 1 - i;
+		uint64_t word;
+		if( bit < 6 )
+			word = g_laneMasks[bit];
+		else
+			word = ((wordIndex >> (bit - 6)) & 1) ? ~(uint64_t)0 : 0;
+		pSlots[uniqueVariables[i] - 'A'] = word;
+	}
+}
+
+CTruthTable::CTruthTable() {
+}
+CTruthTable::CTruthTable( const std::vector<char>& uniqueVariables ) {
+	this->reset( uniqueVariables );
+}
+CTruthTable::~CTruthTable() {
+}
+
+void CTruthTable::reset( const std::vector<char>& uniqueVariables )
+{
+	m_uniqueVariables = uniqueVariables;
+	m_words.assign( (size_t)CTruthTable::getWordCount( (unsigned int)uniqueVariables.size() ), 0 );
+}
+
+bool CTruthTable::get( uint64_t row ) const {
+	return ((m_words[row >> 6] >> (row & 63)) & 1) != 0;
+}
+void CTruthTable::set( uint64_t row, bool value )
+{
+	if( value )
+		m_words[row >> 6] |= ((uint64_t)1 << (row & 63));
+	else
+		m_words[row >> 6] &= ~((uint64_t)1 << (row & 63));
+}
+void CTruthTable::setWord( uint64_t wordIndex, uint64_t word )
+{
+	// Tables under 64 rows only use the low bits of their only word
+	if( m_uniqueVariables.size() < 6 )
+		word &= this->getLastWordMask();
+	m_words[wordIndex] = word;
+}
+
+uint64_t CTruthTable::countOnes() const
+{
+	uint64_t count = 0;
+	for( auto it = m_words.begin(); it != m_words.end(); it++ )
+		count += CountSetBits( (*it) );
+	return count;
+}
+
+uint64_t CTruthTable::getLastWordMask( unsigned int variableCount )
+{
+	if( variableCount >= 6 )
+		return ~(uint64_t)0;
+	return ((uint64_t)1 << (1 << variableCount)) - 1;
+}
+uint64_t CTruthTable::getLastWordMask() const {
+	return getLastWordMask( (unsigned int)m_uniqueVariables.size() );
+}
+
+void CTruthTable::mobiusTransform()
+{
+	unsigned int variableCount = (unsigned int)m_uniqueVariables.size();
+	unsigned int inWordBits = (variableCount < 6 ? variableCount : 6);
+
+	// Row bits below 6 are lanes, each butterfly is a shift and mask per word
+	for( auto it = m_words.begin(); it != m_words.end(); it++ ) {
+		for( unsigned int bit = 0; bit < inWordBits; bit++ )
+			(*it) ^= ((*it) << (1 << bit)) & g_laneMasks[bit];
+	}
+	// Higher row bits pair up whole words
+	for( uint64_t stride = 1; stride < m_words.size(); stride <<= 1 ) {
+		for( uint64_t i = 0; i < m_words.size(); i += stride << 1 ) {
+			for( uint64_t j = i; j < i + stride; j++ )
+				m_words[j + stride] ^= m_words[j];
+		}
+	}
+}
+
+void CTruthTable::getMinterms( std::vector<int> *pMinterms ) const
+{
+	pMinterms->clear();
+	for( uint64_t i = 0; i < m_words.size(); i++ )
+	{
+		uint64_t word = m_words[i];
+		for( int bit = 0; word != 0; bit++, word >>= 1 ) {
+			if( word & 1 )
+				pMinterms->push_back( (int)((i << 6) + bit) );
+		}
+	}
+}
+void CTruthTable::getMaxterms( std::vector<int> *pMaxterms ) const
+{
+	uint64_t rowCount = this->getRowCount();
+
+	pMaxterms->clear();
+	for( uint64_t i = 0; i < rowCount; i++ ) {
+		if( !this->get( i ) )
+			pMaxterms->push_back( (int)i );
+	}
+}
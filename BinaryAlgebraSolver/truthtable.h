@@ -0,0 +1,51 @@
+#pragma once
+#include <stdint.h>
+#include <vector>
+
+// One input slot per letter, the parser only accepts single letter variables
+#define INPUT_SLOT_COUNT 26
+
+// A truth table packed 64 rows to a word. Row i is the same row the solver
+// prints as ConvertIntToBinary( i, n ), so the first variable is the MSB.
+class CTruthTable
+{
+private:
+	std::vector<char> m_uniqueVariables;
+	std::vector<uint64_t> m_words;
+public:
+	static uint64_t getWordCount( unsigned int variableCount );
+	// Lanes of the last word that hold rows, for sizing loops without a table
+	static uint64_t getLastWordMask( unsigned int variableCount );
+	// Lanes of a word whose row index has the given bit (below 6) set
+	static uint64_t getLaneMask( unsigned int bit );
+	static void fillInputSlots( const std::vector<char>& uniqueVariables, uint64_t wordIndex, uint64_t *pSlots );
+
+	CTruthTable();
+	CTruthTable( const std::vector<char>& uniqueVariables );
+	~CTruthTable();
+
+	void reset( const std::vector<char>& uniqueVariables );
+
+	bool get( uint64_t row ) const;
+	void set( uint64_t row, bool value );
+	void setWord( uint64_t wordIndex, uint64_t word );
+	uint64_t countOnes() const;
+	uint64_t getLastWordMask() const;
+
+	// In place fast Mobius transform, turns the table into its algebraic
+	// normal form coefficients. It is its own inverse, so running it on the
+	// coefficients gives the table back. Coefficient m is the AND of the
+	// variables whose bits are set in row m.
+	void mobiusTransform();
+
+	void getMinterms( std::vector<int> *pMinterms ) const;
+	void getMaxterms( std::vector<int> *pMaxterms ) const;
+
+	inline const std::vector<char>& getUniqueVariables() const { return m_uniqueVariables; }
+	inline unsigned int getVariableCount() const { return (unsigned int)m_uniqueVariables.size(); }
+	inline uint64_t getRowCount() const { return (uint64_t)1 << m_uniqueVariables.size(); }
+	inline uint64_t getWordCount() const { return m_words.size(); }
+	inline uint64_t getWord( uint64_t wordIndex ) const { return m_words[wordIndex]; }
+	inline const std::vector<uint64_t>& getWords() const { return m_words; }
+	inline std::vector<uint64_t>& getWords() { return m_words; }
+};
@@ -1,6 +1,10 @@
 #include "util.h"
 #include <bitset>
 #include <algorithm>
+#include <ctype.h>
+#include <math.h>
+#include <stdlib.h>
+#include <fstream>
 
 std::string ConvertIntToBinary( int val, unsigned int digits )
 {
@@ -49,6 +53,31 @@ std::vector<int> ParseDonkeys( std::string donkeys )
 	return donkeyTerms;
 }
 
+bool ReadLines( std::string path, std::vector<std::string> *pLines )
+{
+	std::ifstream file( path );
+	std::string line;
+
+	if( !file )
+		return false;
+
+	pLines->clear();
+	while( std::getline( file, line ) )
+	{
+		// Tolerate files saved with Windows line endings
+		if( line.size() > 0 && line[line.size() - 1] == '\r' )
+			line.erase( line.size() - 1 );
+		pLines->push_back( line );
+	}
+
+	return true;
+}
+
+bool IsBlankLine( const std::string& line )
+{
+	return line.find_first_not_of( " \t" ) == std::string::npos;
+}
+
 /*
 From: http://www.geeksforgeeks.org/given-a-number-n-generate-bit-patterns-from-0-to-2n-1-so-that-successive-patterns-differ-by-one-bit/
 */
@@ -1,10 +1,45 @@
 #pragma once
+#include <stdint.h>
 #include <string>
 #include <vector>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
 
 std::string ConvertIntToBinary( int val, unsigned int digits );
 int ConvertBinaryToInt( std::string binary );
 
 std::vector<std::string> GenerateGrayCode( int bits );
 
-std::vector<int> ParseDonkeys( std::string donkeys );
\ No newline at end of file
+std::vector<int> ParseDonkeys( std::string donkeys );
+
+bool ReadLines( std::string path, std::vector<std::string> *pLines );
+// Batch modes skip these but still count them when numbering lines
+bool IsBlankLine( const std::string& line );
+
+inline int CountSetBits( uint64_t word )
+{
+#if defined( _MSC_VER ) && defined( _M_X64 )
+	return (int)__popcnt64( word );
+#elif defined( _MSC_VER )
+	return (int)(__popcnt( (unsigned int)word ) + __popcnt( (unsigned int)(word >> 32) ));
+#else
+	return __builtin_popcountll( word );
+#endif
+}
+inline int CountTrailingZeros( uint64_t word )
+{
+#if defined( _MSC_VER ) && defined( _M_X64 )
+	unsigned long index;
+	_BitScanForward64( &index, word );
+	return (int)index;
+#elif defined( _MSC_VER )
+	unsigned long index;
+	if( _BitScanForward( &index, (unsigned long)word ) )
+		return (int)index;
+	_BitScanForward( &index, (unsigned long)(word >> 32) );
+	return (int)index + 32;
+#else
+	return __builtin_ctzll( word );
+#endif
+}
\ No newline at end of file